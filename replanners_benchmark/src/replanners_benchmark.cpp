@@ -1,8 +1,10 @@
 #include<graph_core/solvers/birrt.h>
 #include<jsk_rviz_plugins/OverlayText.h>
+#include<replanners_lib/path_library.h>
 #include<replanners_lib/replanner_managers/replanner_manager_DRRT.h>
 #include<replanners_lib/replanner_managers/replanner_manager_MARS.h>
 #include<replanners_lib/replanner_managers/replanner_manager_MPRRT.h>
+#include<replanners_lib/replanner_managers/replanner_manager_portfolio.h>
 #include<replanners_lib/replanner_managers/replanner_manager_DRRTStar.h>
 #include<replanners_lib/replanner_managers/replanner_manager_anytimeDRRT.h>
 
@@ -94,6 +96,24 @@ int main(int argc, char **argv)
     max_solver_time = 20;
   }
 
+  int n_seeds;
+  if (!nh.getParam("n_seeds",n_seeds))
+  {
+    n_seeds = 1;
+  }
+
+  bool reuse_replanner_manager;
+  if (!nh.getParam("reuse_replanner_manager",reuse_replanner_manager))
+  {
+    reuse_replanner_manager = true;
+  }
+
+  std::string path_library_dir;
+  if (!nh.getParam("path_library_dir",path_library_dir))
+  {
+    path_library_dir = ""; //no library
+  }
+
   //  ///////////////////////////////////UPLOADING THE ROBOT ARM/////////////////////////////////////////////////////////////
   moveit::planning_interface::MoveGroupInterface move_group(group_name);
   robot_model_loader::RobotModelLoader robot_model_loader("robot_description");
@@ -187,7 +207,7 @@ int main(int argc, char **argv)
     pathplan::CollisionCheckerPtr checker;
     pathplan::SamplerPtr sampler;
     pathplan::RRTPtr solver;
-    pathplan::PathPtr current_path, new_path;
+    pathplan::PathPtr current_path;
     std::vector<pathplan::PathPtr> other_paths;
     pathplan::ReplannerManagerBasePtr replanner_manager;
     pathplan::TrajectoryPtr trajectory = std::make_shared<pathplan::Trajectory>(nh,planning_scene,group_name);
@@ -243,17 +263,67 @@ int main(int argc, char **argv)
         solver = std::make_shared<pathplan::BiRRT>(metrics,checker,sampler);
         solver->setMaxDistance(max_distance);
 
-        std::srand(std::time(NULL));
-        current_path = trajectory->computePath(start_conf,goal_conf,solver,true,max_solver_time);
+        pathplan::PathLibraryPtr path_library = nullptr;
+        std::vector<pathplan::PathPtr> library_paths, seed_paths;
+        uint64_t scene_hash = 0;
+
+        if(not path_library_dir.empty())
+        {
+          path_library = std::make_shared<pathplan::PathLibrary>(path_library_dir,group_name);
+          scene_hash = pathplan::PathLibrary::sceneHash(ps_srv.response.scene.world);
+          library_paths = path_library->load(start_conf,goal_conf,scene_hash,metrics,checker);
+        }
+
+        // The library keeps the roles: the current path first, then the other paths. Invalid ones are nullptr
+        std::vector<pathplan::PathPtr> library_other_paths;
+        for(unsigned int k=1;k<library_paths.size();k++)
+        {
+          if(library_paths.at(k))
+            library_other_paths.push_back(library_paths.at(k));
+        }
+
+        bool library_changed = false;
+        if(not library_paths.empty() && library_paths.front())
+        {
+          current_path = library_paths.front();
+          ROS_INFO_STREAM("current path loaded from library");
+        }
+        else
+        {
+          std::srand(std::time(NULL));
+          if(n_seeds>1)
+            current_path = trajectory->computePath(start_conf,goal_conf,solver,n_seeds,seed_paths,true,max_solver_time);
+          else
+            current_path = trajectory->computePath(start_conf,goal_conf,solver,true,max_solver_time);
+
+          library_changed = true;
+        }
 
         if(not current_path)
           continue;
         else
           ROS_INFO_STREAM("current path cost "<<current_path->cost());
 
+        // MARS saves the library once it has its other paths
+        if(path_library && library_changed && replanner_type != "MARS")
+        {
+          std::vector<pathplan::PathPtr> paths = {current_path};
+          paths.insert(paths.end(),library_other_paths.begin(),library_other_paths.end());
+          path_library->save(paths,start_conf,goal_conf,scene_hash,max_distance);
+        }
+
         // //////////////////////////////////////////DEFINING THE REPLANNER//////////////////////////////////////////////
-        replanner_manager.reset();
-        if(replanner_type == "MPRRT")
+        // A manager built for a previous query is reused: only the path and goal change between queries
+        bool reuse = (reuse_replanner_manager && replanner_manager);
+        if(not reuse)
+          replanner_manager.reset();
+
+        if(reuse && replanner_type != "MARS")
+        {
+          if(not replanner_manager->reset(current_path,goal_conf))
+            continue;
+        }
+        else if(replanner_type == "MPRRT")
         {
           replanner_manager.reset(new pathplan::ReplannerManagerMPRRT(current_path,solver,nh));
         }
@@ -269,6 +339,10 @@ int main(int argc, char **argv)
         {
           replanner_manager.reset(new pathplan::ReplannerManagerAnytimeDRRT(current_path,solver,nh));
         }
+        else if(replanner_type == "portfolio")
+        {
+          replanner_manager.reset(new pathplan::ReplannerManagerPortfolio(current_path,solver,nh));
+        }
         else if(replanner_type == "MARS")
         {
           int n_other_paths;
@@ -278,27 +352,83 @@ int main(int argc, char **argv)
             n_other_paths = 1;
           }
 
-          for(unsigned int i=0;i<n_other_paths;i++)
+          double other_paths_min_distance;
+          if (!nh.getParam("/MARS/other_paths_min_distance",other_paths_min_distance))
+          {
+            ROS_ERROR("other_paths_min_distance not set, set 0.0");
+            other_paths_min_distance = 0.0;
+          }
+
+          int other_paths_candidates;
+          if (!nh.getParam("/MARS/other_paths_candidates",other_paths_candidates))
+          {
+            ROS_ERROR("other_paths_candidates not set, set 3");
+            other_paths_candidates = 3;
+          }
+
+          // The stored other paths still valid are used first
+          unsigned int n_library_other_paths = std::min((unsigned int) library_other_paths.size(),(unsigned int) std::max(n_other_paths,0));
+          other_paths.assign(library_other_paths.begin(),library_other_paths.begin()+n_library_other_paths);
+          if(n_library_other_paths>0)
+            ROS_INFO_STREAM(n_library_other_paths<<" other paths loaded from library");
+
+          if((int) other_paths.size()<n_other_paths)
           {
             std::srand(std::time(NULL));
             solver = std::make_shared<pathplan::BiRRT>(metrics,checker,sampler);
-            new_path = trajectory->computePath(start_conf,goal_conf,solver,true,max_solver_time);
+            solver->setMaxDistance(max_distance);
 
-            other_paths.clear();
-            if(new_path)
+            // Then the other solutions of the parallel seeds far enough from the current path and from each other
+            std::vector<pathplan::PathPtr> paths2avoid = {current_path};
+            paths2avoid.insert(paths2avoid.end(),other_paths.begin(),other_paths.end());
+            for(unsigned int k=1;k<seed_paths.size() && (int) other_paths.size()<n_other_paths;k++)
             {
-              other_paths.push_back(new_path);
-              ROS_INFO_STREAM("other path cost "<<new_path->cost());
-              assert(new_path->getTree());
+              double distance = std::numeric_limits<double>::infinity();
+              for(const pathplan::PathPtr& p:paths2avoid)
+                distance = std::min(distance,pathplan::Trajectory::frechetDistance(seed_paths.at(k),p));
+
+              if(distance>=other_paths_min_distance)
+              {
+                other_paths.push_back(seed_paths.at(k));
+                paths2avoid.push_back(seed_paths.at(k));
+              }
             }
-            else
-              ROS_INFO("other path not found");
+
+            std::vector<pathplan::PathPtr> diverse_paths = trajectory->computeDiversePaths(start_conf,goal_conf,solver,n_other_paths-other_paths.size(),paths2avoid,
+                                                                                           other_paths_min_distance,std::max(other_paths_candidates,1),true,max_solver_time);
+            other_paths.insert(other_paths.end(),diverse_paths.begin(),diverse_paths.end());
+
+            library_changed = true;
           }
 
-          std::srand(std::time(NULL));
-          solver = std::make_shared<pathplan::BiRRT>(metrics,checker,sampler);
-          solver->config(nh);
-          replanner_manager = std::make_shared<pathplan::ReplannerManagerMARS>(current_path,solver,nh,other_paths);
+          if(path_library && library_changed)
+          {
+            std::vector<pathplan::PathPtr> paths = {current_path};
+            paths.insert(paths.end(),other_paths.begin(),other_paths.end());
+            paths.insert(paths.end(),library_other_paths.begin()+n_library_other_paths,library_other_paths.end());
+            path_library->save(paths,start_conf,goal_conf,scene_hash,max_distance);
+          }
+          for(const pathplan::PathPtr& p:other_paths)
+          {
+            ROS_INFO_STREAM("other path cost "<<p->cost());
+            assert(p->getTree());
+          }
+          if((int) other_paths.size()<n_other_paths)
+            ROS_INFO_STREAM(n_other_paths-(int) other_paths.size()<<" other paths not found");
+
+          if(reuse)
+          {
+            std::static_pointer_cast<pathplan::ReplannerManagerMARS>(replanner_manager)->setOtherPaths(other_paths);
+            if(not replanner_manager->reset(current_path,goal_conf))
+              continue;
+          }
+          else
+          {
+            std::srand(std::time(NULL));
+            solver = std::make_shared<pathplan::BiRRT>(metrics,checker,sampler);
+            solver->config(nh);
+            replanner_manager = std::make_shared<pathplan::ReplannerManagerMARS>(current_path,solver,nh,other_paths);
+          }
         }
         else
         {
@@ -0,0 +1,79 @@
+#ifndef ANALYTIC_COLLISION_CHECKER_H__
+#define ANALYTIC_COLLISION_CHECKER_H__
+
+#include <map>
+#include <ros/ros.h>
+#include <Eigen/Geometry>
+#include <graph_core/collision_checker.h>
+#include <moveit_msgs/PlanningScene.h>
+#include <shape_msgs/SolidPrimitive.h>
+
+namespace pathplan
+{
+class AnalyticCollisionChecker;
+typedef std::shared_ptr<AnalyticCollisionChecker> AnalyticCollisionCheckerPtr;
+
+/* Collision checker for worlds made of spheres and axis-aligned boxes, without FCL and planning scene.
+ * The first (up to) three joints of the configuration are the position of the robot, which is approximated
+ * by a set of spheres (columns x,y,z offset and radius), e.g. a single sphere with zero offset for a point robot.
+ * Obstacles are stored as structures of arrays so that the distance tests are vectorized by Eigen:
+ * check() tests one configuration against all the obstacles at once, checkPath() tests all the
+ * configurations along the connection against one obstacle at once.
+ * Positions are expressed in world_frame: collision objects are placed by their pose and header frame, which must be
+ * world_frame (or empty) or one of the fixed frames of the scene message defined with respect to world_frame. */
+class AnalyticCollisionChecker: public CollisionChecker
+{
+protected:
+  struct Obstacles
+  {
+    std::vector<Eigen::Vector4d> spheres; //center, radius
+    std::vector<Eigen::Matrix<double,6,1>> boxes; //center, half extents
+  };
+
+  std::map<std::string,Obstacles> objects_;
+  std::map<std::string,std::vector<moveit_msgs::CollisionObject>> object_msgs_; //to move objects
+  std::map<std::string,Eigen::Isometry3d> frames_; //fixed frames in world_frame_
+  std::string world_frame_;
+
+  Eigen::Matrix4Xd robot_spheres_;
+
+  Eigen::ArrayXd sphere_x_, sphere_y_, sphere_z_, sphere_r_;
+  Eigen::ArrayXd box_x_, box_y_, box_z_, box_hx_, box_hy_, box_hz_;
+
+  unsigned int batch_size_;
+
+  void updateArrays();
+  bool objectPose(const moveit_msgs::CollisionObject& object, Eigen::Isometry3d& pose) const;
+  bool addCollisionObject(const moveit_msgs::CollisionObject& object, Obstacles& obstacles);
+  Eigen::Vector3d position(const Eigen::VectorXd& configuration) const;
+  bool checkBatch(const Eigen::ArrayXd& x, const Eigen::ArrayXd& y, const Eigen::ArrayXd& z) const;
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  AnalyticCollisionChecker(const Eigen::Matrix4Xd& robot_spheres,
+                           const double& min_distance = 0.01,
+                           const unsigned int& batch_size = 256,
+                           const std::string& world_frame = "world");
+
+  void addSphere(const std::string& id, const Eigen::Vector3d& center, const double& radius);
+  void addBox(const std::string& id, const Eigen::Vector3d& center, const Eigen::Vector3d& half_extents);
+  void removeObject(const std::string& id);
+  void clearObjects();
+
+  /* World collision objects made of primitives are converted into spheres and boxes: rotated boxes, cylinders
+   * and cones are replaced by their axis-aligned bounding box, meshes and attached objects are ignored.
+   * Objects in a frame which can not be resolved are skipped */
+  void setPlanningSceneMsg(const moveit_msgs::PlanningScene& msg) override;
+
+  bool check(const Eigen::VectorXd& configuration) override;
+  bool checkPath(const Eigen::VectorXd& configuration1, const Eigen::VectorXd& configuration2) override;
+
+  CollisionCheckerPtr clone() override
+  {
+    return std::make_shared<AnalyticCollisionChecker>(*this);
+  }
+};
+}
+
+#endif // ANALYTIC_COLLISION_CHECKER_H
@@ -0,0 +1,57 @@
+#ifndef BATCH_COLLISION_CHECKER_H__
+#define BATCH_COLLISION_CHECKER_H__
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <limits>
+#include <graph_core/graph/connection.h>
+#include <graph_core/collision_checker.h>
+
+namespace pathplan
+{
+class BatchCollisionChecker;
+typedef std::shared_ptr<BatchCollisionChecker> BatchCollisionCheckerPtr;
+
+/* Collision checks of many configurations or segments at once, spread over a pool of independent checkers (one per worker).
+ * Each segment is checked entirely by one worker, which stops at its first collision, so many short connections keep
+ * all the workers busy instead of splitting each of them among the workers.
+ * With stop_at_first_collision the workers skip the segments after the first obstructed one found so far:
+ * all the segments before the first obstructed one are always checked, the following ones may be left unchecked.
+ * Segments not started within max_time seconds are left unchecked too, the running ones are completed. */
+class BatchCollisionChecker
+{
+protected:
+  std::vector<CollisionCheckerPtr> checkers_;
+
+public:
+  enum Status {UNCHECKED = -1, OBSTRUCTED = 0, FREE = 1};
+
+  /* The checkers should be sequential (e.g. MoveitCollisionChecker), each of them is used by a single worker */
+  BatchCollisionChecker(const std::vector<CollisionCheckerPtr>& checkers);
+
+  /* Workers using clones of checker */
+  BatchCollisionChecker(const CollisionCheckerPtr& checker, const unsigned int& n_workers);
+
+  void setPlanningSceneMsg(const moveit_msgs::PlanningScene& msg);
+
+  std::vector<bool> check(const std::vector<Eigen::VectorXd>& configurations);
+
+  std::vector<int> checkPaths(const std::vector<std::pair<Eigen::VectorXd,Eigen::VectorXd>>& segments, const bool& stop_at_first_collision = false,
+                              const double& max_time = std::numeric_limits<double>::infinity());
+  std::vector<int> checkConnections(const std::vector<ConnectionPtr>& connections, const bool& stop_at_first_collision = false,
+                                    const double& max_time = std::numeric_limits<double>::infinity());
+
+  unsigned int getWorkersNumber() const
+  {
+    return checkers_.size();
+  }
+
+  const std::vector<CollisionCheckerPtr>& getCheckers() const
+  {
+    return checkers_;
+  }
+};
+}
+
+#endif // BATCH_COLLISION_CHECKER_H
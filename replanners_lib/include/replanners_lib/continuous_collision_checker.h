@@ -0,0 +1,60 @@
+#ifndef CONTINUOUS_COLLISION_CHECKER_H__
+#define CONTINUOUS_COLLISION_CHECKER_H__
+
+#include <graph_core/collision_checker.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <replanners_lib/sdf_collision_checker.h>
+
+namespace pathplan
+{
+class ContinuousCollisionChecker;
+typedef std::shared_ptr<ContinuousCollisionChecker> ContinuousCollisionCheckerPtr;
+
+/* Collision checker which certifies whole segments by conservative advancement instead of sampling them at a fixed resolution.
+ * At each configuration the distance between the robot and the world is computed by the planning scene and no point
+ * of the robot (attached bodies included, their shapes extend the reach of the link they are attached to) can move farther
+ * than lever_arms*|dq| (see SdfCollisionChecker::leverArms), so the segment is free up to the
+ * configuration at which that bound reaches the distance. Free segments far from obstacles are certified in a few queries,
+ * near obstacles the steps shrink (never below min_distance_) and the first contact is found within min_distance_.
+ * Self collisions (optional) are checked by sampling at min_distance_ up to the first contact with the world. */
+class ContinuousCollisionChecker: public CollisionChecker
+{
+protected:
+  planning_scene::PlanningScenePtr planning_scene_;
+  std::string group_name_;
+  robot_state::RobotStatePtr state_;
+  const robot_state::JointModelGroup* jmg_;
+
+  Eigen::MatrixXd lever_arms_; //number of moving links with geometry or attached bodies x number of joints
+  bool check_self_collisions_;
+
+  void computeLeverArms();
+  double distance(const Eigen::VectorXd& configuration);
+  bool checkSelfCollision(const Eigen::VectorXd& configuration);
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  ContinuousCollisionChecker(const planning_scene::PlanningScenePtr& planning_scene,
+                             const std::string& group_name,
+                             const bool& check_self_collisions = true,
+                             const double& min_distance = 0.01);
+
+  void setPlanningSceneMsg(const moveit_msgs::PlanningScene& msg) override;
+
+  bool check(const Eigen::VectorXd& configuration) override;
+  bool checkPath(const Eigen::VectorXd& configuration1, const Eigen::VectorXd& configuration2) override;
+
+  /* Return true if the segment is in collision, contact is the first configuration in collision found along it */
+  bool firstContact(const Eigen::VectorXd& configuration1, const Eigen::VectorXd& configuration2, Eigen::VectorXd& contact);
+
+  CollisionCheckerPtr clone() override;
+
+  planning_scene::PlanningScenePtr getPlanningScene() override
+  {
+    return planning_scene_;
+  }
+};
+}
+
+#endif // CONTINUOUS_COLLISION_CHECKER_H
@@ -0,0 +1,85 @@
+#ifndef DISTANCE_FIELD_H__
+#define DISTANCE_FIELD_H__
+
+#include <map>
+#include <algorithm>
+#include <ros/ros.h>
+#include <Eigen/Geometry>
+#include <moveit_msgs/PlanningSceneWorld.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <shape_msgs/SolidPrimitive.h>
+
+namespace pathplan
+{
+class DistanceField;
+typedef std::shared_ptr<DistanceField> DistanceFieldPtr;
+
+/* Truncated signed distance field of the world collision objects, sampled on a voxel grid in the planning frame.
+ * The objects are placed by their pose and, given the planning scene, by the transform of their header frame.
+ * Each object only affects the voxels of its bounding box inflated by the truncation distance, so adding,
+ * moving or removing an object recomputes only those voxels.
+ * Spheres, boxes and cylinders are exact, cones are replaced by cylinders and meshes by their oriented
+ * bounding box. Planes and the parts of the world outside the grid are ignored. */
+class DistanceField
+{
+protected:
+  struct Shape
+  {
+    uint8_t type;
+    Eigen::Isometry3d inverse_pose;
+    Eigen::Vector3d dimensions; //sphere: radius; box: half extents; cylinder: radius, radius, half height
+  };
+
+  struct Object
+  {
+    std::vector<Shape> shapes;
+    Eigen::AlignedBox3d region;
+    moveit_msgs::CollisionObject msg;
+  };
+
+  std::map<std::string,Object> objects_;
+
+  Eigen::Vector3d origin_;
+  Eigen::Vector3i size_;
+  double resolution_;
+  double truncation_;
+  double voxel_radius_;
+  std::vector<float> distance_;
+
+  bool sameGeometry(const moveit_msgs::CollisionObject& obj1, const moveit_msgs::CollisionObject& obj2) const;
+  Object fromMsg(const moveit_msgs::CollisionObject& msg, const planning_scene::PlanningSceneConstPtr& scene) const;
+  void updateRegion(const Eigen::AlignedBox3d& region);
+
+  static double shapeDistance(const Shape& shape, const Eigen::Vector3d& point);
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  DistanceField(const Eigen::Vector3d& lb,
+                const Eigen::Vector3d& ub,
+                const double& resolution = 0.02,
+                const double& truncation = 0.3);
+
+  void addObject(const moveit_msgs::CollisionObject& object, const planning_scene::PlanningSceneConstPtr& scene = nullptr);
+  void removeObject(const std::string& id);
+  void clearObjects();
+
+  //Objects not in a diff world are kept, as in MoveIt. Only new, moved or removed objects are recomputed
+  void setWorldMsg(const moveit_msgs::PlanningSceneWorld& world, const bool& is_diff, const planning_scene::PlanningSceneConstPtr& scene = nullptr);
+  bool needsUpdate(const moveit_msgs::PlanningSceneWorld& world, const bool& is_diff) const;
+
+  //Lower bound of the signed distance from the closest object, the truncation distance if farther or outside the grid
+  double distance(const Eigen::Vector3d& point) const;
+
+  double getTruncation() const
+  {
+    return truncation_;
+  }
+  double getResolution() const
+  {
+    return resolution_;
+  }
+};
+}
+
+#endif // DISTANCE_FIELD_H
@@ -0,0 +1,76 @@
+#ifndef OBSTACLE_PREDICTOR_H__
+#define OBSTACLE_PREDICTOR_H__
+
+#include <map>
+#include <cmath>
+#include <memory>
+#include <Eigen/Geometry>
+#include <moveit_msgs/PlanningSceneWorld.h>
+
+namespace pathplan
+{
+class ObstaclePredictor;
+typedef std::shared_ptr<ObstaclePredictor> ObstaclePredictorPtr;
+
+/* Constant velocity prediction of the objects of the world.
+ * The velocity of each object is estimated from the displacement of its first shape (object pose composed with the shape pose,
+ * in the header frame of the object) between two updates in which it moved, and it is reset if the object does not move for
+ * longer than the prediction horizon or if its header frame changes.
+ * The predicted world is divided in time bands of size step: in each band the moving objects are swept along their velocity,
+ * i.e. their shapes are replicated at close enough instants to cover all the positions they occupy in that band.
+ * Fast or thin objects which would need more than max_copies replicas are replaced by a single box bounding the sweep. */
+class ObstaclePredictor
+{
+protected:
+  struct Track
+  {
+    Eigen::Vector3d position;
+    Eigen::Vector3d velocity;
+    double time;
+    std::string frame;
+  };
+
+  double horizon_;
+  double step_;
+  unsigned int max_copies_;
+  std::map<std::string,Track> tracks_;
+
+  static Eigen::Isometry3d fromPoseMsg(const geometry_msgs::Pose& pose);
+  static bool objectPosition(const moveit_msgs::CollisionObject& object, Eigen::Vector3d& position);
+  static double minExtent(const moveit_msgs::CollisionObject& object);
+  static bool localBox(const moveit_msgs::CollisionObject& object, Eigen::Vector3d& lb, Eigen::Vector3d& ub); //in the object frame
+
+public:
+  ObstaclePredictor(const double& horizon, const double& step, const unsigned int& max_copies = 20);
+
+  void update(const moveit_msgs::PlanningSceneWorld& world, const double& time);
+
+  Eigen::Vector3d velocity(const std::string& id) const;
+
+  //World with the moving objects swept over [t0,t1] seconds from the last update
+  moveit_msgs::PlanningSceneWorld predict(const moveit_msgs::PlanningSceneWorld& world, const double& t0, const double& t1) const;
+
+  unsigned int bands() const
+  {
+    return std::ceil(horizon_/step_);
+  }
+
+  //Band of the instant t, instants beyond the horizon belong to the last band
+  unsigned int band(const double& t) const
+  {
+    return std::min((unsigned int) std::max(std::floor(t/step_),0.0),bands()-1);
+  }
+
+  double getHorizon() const
+  {
+    return horizon_;
+  }
+
+  double getStep() const
+  {
+    return step_;
+  }
+};
+}
+
+#endif // OBSTACLE_PREDICTOR_H
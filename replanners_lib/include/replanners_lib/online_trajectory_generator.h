@@ -0,0 +1,131 @@
+#ifndef ONLINE_TRAJECTORY_GENERATOR_H__
+#define ONLINE_TRAJECTORY_GENERATOR_H__
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <Eigen/Core>
+
+namespace pathplan
+{
+class OnlineTrajectoryGenerator;
+typedef std::shared_ptr<OnlineTrajectoryGenerator> OnlineTrajectoryGeneratorPtr;
+
+/* Fast timing of a piecewise linear path starting from the current state of the robot.
+ * The path is timed in a single forward/backward pass on the speed along the path: each segment has a trapezoidal
+ * speed profile limited by the joint velocity and acceleration limits, and the speed at the waypoints is limited so that
+ * the change of direction does not exceed the acceleration limits. The path starts with the component of the current
+ * velocity along its first segment.
+ * The current state (position, velocity, acceleration) is spliced onto the straight initial part of the timed path (up to
+ * max_deviation from the chord) by a quintic blend which reaches a point of it with its position, velocity and acceleration.
+ * The earliest point which can be reached within the velocity, acceleration and jerk limits (checked at the extrema of each
+ * joint, not sampled) and without leaving a tube of radius max_deviation around the chord is chosen, so the trajectory is
+ * continuous in acceleration, jerk limited at the splice and does not leave the path. If no such point exists, no
+ * trajectory is generated. */
+class OnlineTrajectoryGenerator
+{
+public:
+  struct Setpoint
+  {
+    double time;
+    Eigen::VectorXd position;
+    Eigen::VectorXd velocity;
+    Eigen::VectorXd acceleration;
+  };
+
+protected:
+  Eigen::VectorXd max_velocity_;
+  Eigen::VectorXd max_acceleration_;
+  Eigen::VectorXd max_jerk_;
+  double blend_step_;
+  double max_deviation_;
+
+  struct Quintic
+  {
+    double duration;
+    Eigen::VectorXd c0,c1,c2,c3,c4,c5;
+
+    Setpoint evaluate(const double& t) const;
+  };
+
+  /* Trapezoidal speed profile along a segment of the path */
+  struct Segment
+  {
+    Eigen::VectorXd start;
+    Eigen::VectorXd dir;
+    double length;
+    double max_speed;
+    double max_acc;
+    double start_speed;
+    double end_speed;
+
+    /* State at the curvilinear abscissa s, time from the start of the segment */
+    Setpoint at(const double& s) const;
+    double duration() const
+    {
+      return at(length).time;
+    }
+  };
+
+  static Quintic quintic(const Setpoint& start, const Setpoint& end);
+
+  /* Real roots in [lo,hi] of the polynomial c[0]+c[1]*t+c[2]*t^2+..., isolated between the roots of its derivative and refined by bisection */
+  static std::vector<double> roots(const std::vector<double>& c, const double& lo, const double& hi);
+  static double maxAbs(const std::vector<double>& c, const double& duration);
+
+  bool withinLimits(const Quintic& blend) const;
+
+  /* Distance of q from the segment from a to b */
+  static double distance(const Eigen::VectorXd& q, const Eigen::VectorXd& a, const Eigen::VectorXd& b);
+
+  /* The blend lies in the convex hull of its Bernstein control points, so it is within radius from the segment from a to b if they are */
+  static bool withinTube(const Quintic& blend, const Eigen::VectorXd& a, const Eigen::VectorXd& b, const double& radius);
+
+  std::vector<Setpoint> timePath(const std::vector<Eigen::VectorXd>& waypoints, const Eigen::VectorXd& start_velocity, std::vector<Segment>& segments) const;
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  OnlineTrajectoryGenerator(const Eigen::VectorXd& max_velocity,
+                            const Eigen::VectorXd& max_acceleration,
+                            const Eigen::VectorXd& max_jerk,
+                            const double& blend_step = 0.01,
+                            const double& max_deviation = 0.01);
+
+  /* Direction, length, speed and acceleration limits of the segments between the waypoints (zero direction for coincident ones)
+   * and speed at the waypoints: zero at the ends, elsewhere limited by the adjacent segments and by the acceleration needed to
+   * turn, i.e. v^2*|du|/l over the shortest adjacent segment l. Acceleration limits along the segments are not propagated */
+  static void segmentLimits(const std::vector<Eigen::VectorXd>& waypoints, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration,
+                            std::vector<Eigen::VectorXd>& dir, std::vector<double>& length, std::vector<double>& max_speed,
+                            std::vector<double>& max_acc, std::vector<double>& speed);
+
+  /* Timing of the waypoints (coincident ones are removed) starting with the component of start_velocity along the path, without blend */
+  std::vector<Setpoint> timePath(const std::vector<Eigen::VectorXd>& waypoints, const Eigen::VectorXd& start_velocity) const
+  {
+    std::vector<Segment> segments;
+    return timePath(waypoints,start_velocity,segments);
+  }
+
+  /* Trajectory from the current state along the waypoints, stopping at the last one. Times start from 0.
+   * False if the current state cannot be spliced onto the first segment of the path, trajectory is not modified then */
+  bool generate(const std::vector<Eigen::VectorXd>& waypoints,
+                const Eigen::VectorXd& position,
+                const Eigen::VectorXd& velocity,
+                const Eigen::VectorXd& acceleration,
+                std::vector<Setpoint>& trajectory) const;
+
+  /* Trajectory from rest at the first waypoint, there is nothing to splice */
+  std::vector<Setpoint> generate(const std::vector<Eigen::VectorXd>& waypoints) const
+  {
+    if(waypoints.empty())
+      throw std::invalid_argument("no waypoints");
+
+    return timePath(waypoints,Eigen::VectorXd::Zero(max_velocity_.size()));
+  }
+};
+}
+
+#endif // ONLINE_TRAJECTORY_GENERATOR_H
@@ -0,0 +1,67 @@
+#ifndef PATH_LIBRARY_H__
+#define PATH_LIBRARY_H__
+
+#include <ros/ros.h>
+#include <fcntl.h>
+#include <future>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <boost/filesystem.hpp>
+#include <graph_core/metrics.h>
+#include <graph_core/graph/path.h>
+#include <graph_core/graph/tree.h>
+#include <graph_core/collision_checker.h>
+#include <moveit_msgs/PlanningSceneWorld.h>
+
+namespace pathplan
+{
+class PathLibrary;
+typedef std::shared_ptr<PathLibrary> PathLibraryPtr;
+
+/* Binary library of paths (with their trees and costs) keyed by group, start, goal and static scene.
+ * File layout (native endianness):
+ * header: magic, version, scene hash, dof, group name, start, goal, tree max distance, number of paths
+ * for each path: number of tree nodes, nodes (configuration, parent index, cost of the parent connection),
+ * number of path nodes, indices of the path nodes in the tree */
+class PathLibrary: public std::enable_shared_from_this<PathLibrary>
+{
+protected:
+  std::string directory_;
+  std::string group_name_;
+
+  std::string fileName(const Eigen::VectorXd& start_conf, const Eigen::VectorXd& goal_conf, const uint64_t& scene_hash) const;
+  PathPtr readPath(const char*& ptr, const char* end, const unsigned int& dof, const double& max_distance, const MetricsPtr& metrics, const CollisionCheckerPtr& checker) const;
+  void writePath(std::ofstream& file, const PathPtr& path) const;
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  PathLibrary(const std::string& directory,
+              const std::string& group_name);
+
+  PathLibraryPtr pointer()
+  {
+    return shared_from_this();
+  }
+
+  bool save(const std::vector<PathPtr>& paths, const Eigen::VectorXd& start_conf, const Eigen::VectorXd& goal_conf,
+            const uint64_t& scene_hash, const double& max_distance) const;
+
+  /* Paths in the same order (i.e. with the same role) they were saved, an empty vector if there is no library for the query.
+   * Unreadable paths and, if validate is true, the ones not valid in the current scene are nullptr */
+  std::vector<PathPtr> load(const Eigen::VectorXd& start_conf, const Eigen::VectorXd& goal_conf, const uint64_t& scene_hash,
+                            const MetricsPtr& metrics, const CollisionCheckerPtr& checker, const bool& validate = true) const;
+
+  //Key of the static scene (collision objects, not the octomap), the same across runs and builds
+  static uint64_t sceneHash(const moveit_msgs::PlanningSceneWorld& world);
+};
+}
+
+#endif // PATH_LIBRARY_H
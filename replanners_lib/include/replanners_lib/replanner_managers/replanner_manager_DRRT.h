@@ -15,6 +15,7 @@ protected:
 
   virtual bool haveToReplan(const bool path_obstructed) override;
   virtual void initReplanner() override;
+  virtual ReplannerBasePtr speculativeReplanner(Eigen::VectorXd& configuration, PathPtr& path) override;
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -23,6 +24,8 @@ public:
                        const TreeSolverPtr &solver,
                        const ros::NodeHandle &nh);
 
+  ~ReplannerManagerDRRT();
+
   void startReplannedPathFromNewCurrentConf(const Eigen::VectorXd& configuration) override;
 };
 
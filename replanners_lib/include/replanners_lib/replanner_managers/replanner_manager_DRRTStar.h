@@ -25,7 +25,10 @@ public:
                            const TreeSolverPtr &solver,
                            const ros::NodeHandle &nh);
 
+  ~ReplannerManagerDRRTStar();
+
   void startReplannedPathFromNewCurrentConf(const Eigen::VectorXd &configuration) override;
+  bool reset(const PathPtr& current_path, const Eigen::VectorXd& goal_conf) override;
 };
 
 }
@@ -17,16 +17,38 @@ protected:
   bool first_replanning_;
   bool reverse_start_nodes_;
   bool display_other_paths_;
+  bool fallback_paths_;
+  bool other_paths_reset_;
+  bool path_changed_;
   int verbosity_level_;
+  int n_fallback_paths_;
+  int max_fallback_paths_;
+  int gc_node_budget_;
+  int gc_other_paths_to_keep_;
   double dt_replan_relaxed_;
+  double fallback_paths_frequency_;
+  double gc_period_;
+  ros::WallTime last_gc_time_;
   NodePtr old_current_node_;
   PathPtr initial_path_;
   std::mutex other_paths_mtx_;
   std::vector<PathPtr> other_paths_;
   std::vector<PathPtr> other_paths_shared_;
   std::vector<bool> other_paths_sync_needed_;
+  std::vector<PathPtr> fallback_paths_queue_;          // computed by the fallback paths thread, merged by the replanning thread
+  std::vector<unsigned int> fallback_paths_idx_;       // indices of the fallback paths in other_paths_shared_
+  std::vector<Eigen::VectorXd> fallback_junctions_;    // configurations where the fallback paths leave the current path
+  std::thread fallback_paths_thread_;
+  TreeSolverPtr fallback_solver_;                      // prototype of the fallback paths solvers, never used by the replanning thread
 
-  bool checkPathTask(const PathPtr& path);
+  bool checkPathTask(const PathPtr& path, const CollisionCheckerPtr& checker, const std::vector<bool>& static_validity,
+                     const std::vector<unsigned int>& conn_ids, const bool& full_check);
+  unsigned int validFallbackPaths();
+  void evictFallbackPaths();
+  void mergeFallbackPaths();
+  void alignOtherPaths();
+  void fallbackPathsThread();
+  void compactNet(const double& max_time);
   void MARSadditionalParams();
   void displayCurrentPath();
   void displayOtherPaths();
@@ -34,12 +56,15 @@ protected:
   bool uploadPathsCost(const PathPtr& current_path_updated_copy, const std::vector<PathPtr>& other_paths_updated_copy);
   void displayThread() override;
   bool haveToReplan(const bool path_obstructed) override;
+  double computeTimeShift() override;
   virtual void updateSharedPath() override;
   virtual void attributeInitialization() override;
 
   virtual bool replan() override;
+  void replanningIdleTime(const double& available_time) override;
   virtual void initReplanner() override;
   virtual void collisionCheckThread() override;
+  virtual void launchThreads() override;
   virtual bool updateTrajectory() override;
 
 public:
@@ -59,6 +84,9 @@ public:
     other_paths_ = other_paths;
   }
 
+  ~ReplannerManagerMARS();
+
+  virtual bool reset(const PathPtr& current_path, const Eigen::VectorXd& goal_conf) override;
   virtual void startReplannedPathFromNewCurrentConf(const Eigen::VectorXd& configuration) override;
 };
 
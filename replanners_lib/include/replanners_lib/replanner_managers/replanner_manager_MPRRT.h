@@ -16,6 +16,7 @@ protected:
 
   bool haveToReplan(const bool path_obstructed) override;
   void initReplanner() override;
+  ReplannerBasePtr speculativeReplanner(Eigen::VectorXd& configuration, PathPtr& path) override;
   void additionalParams();
 
 public:
@@ -25,6 +26,8 @@ public:
                          const TreeSolverPtr &solver,
                          const ros::NodeHandle &nh);
 
+  ~ReplannerManagerMPRRT();
+
   void startReplannedPathFromNewCurrentConf(const Eigen::VectorXd &configuration) override;
 };
 
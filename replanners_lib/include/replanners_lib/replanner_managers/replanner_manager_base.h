@@ -2,12 +2,24 @@
 #define REPLANNER_MANAGER_BASE_H__
 
 #include <mutex>
+#include <deque>
 #include <thread>
+#include <future>
+#include <functional>
 #include <std_msgs/Int64.h>
 #include <condition_variable>
 #include <std_msgs/ColorRGBA.h>
+#include <trajectory_msgs/JointTrajectory.h>
 #include <boost/filesystem.hpp>
+#include <octomap/OcTree.h>
+#include <octomap_msgs/conversions.h>
 #include <replanners_lib/trajectory.h>
+#include <replanners_lib/swept_volume_grid.h>
+#include <replanners_lib/obstacle_predictor.h>
+#include <replanners_lib/sdf_collision_checker.h>
+#include <replanners_lib/continuous_collision_checker.h>
+#include <replanners_lib/batch_collision_checker.h>
+#include <replanners_lib/shared_joint_target.h>
 #include <jsk_rviz_plugins/OverlayText.h>
 #include <object_loader_msgs/AddObjects.h>
 #include <object_loader_msgs/MoveObjects.h>
@@ -55,10 +67,31 @@ protected:
   bool current_path_sync_needed_  ;
   bool display_current_trj_point_ ;
   bool display_replanning_success_;
+  bool adaptive_time_shift_       ;
+  bool path_cost_increased_       ;
+  bool demand_driven_replanning_  ;
+  bool speculative_replanning_    ;
+  bool resources_initialized_     ;
+  bool sdf_checker_               ;
+  bool sdf_self_collisions_       ;
+  bool continuous_checker_        ;
+  bool continuous_self_collisions_;
+  bool batch_checks_              ;
+  bool octomap_updates_           ;
+  bool online_trajectory_generator_;
+  bool adaptive_resampling_       ;
+  bool setpoint_streaming_        ;
+  bool shared_memory_target_      ;
+  bool static_dynamic_split_      ;
+  bool swept_volume_invalidation_ ;
+  bool prioritized_path_checks_   ;
+  bool obstacle_prediction_       ;
 
   int spline_order_              ;
   int parallel_checker_n_threads_;
   int direction_change_          ;
+  int latency_window_size_       ;
+  int check_max_period_          ;
 
   double t_                          ;
   double dt_                         ;
@@ -67,6 +100,7 @@ protected:
   double time_shift_                 ;
   double t_replan_                   ;
   double replanning_time_            ;
+  double trajectory_time_            ;
   double replanning_thread_frequency_;
   double scaling_from_param_         ;
   double checker_resolution_         ;
@@ -75,8 +109,32 @@ protected:
   double global_override_            ;
   double obj_vel_                    ;
   double dt_move_                    ;
+  double dt_replan_min_              ;
+  double latency_margin_             ;
+  double latency_percentile_         ;
+  double improvement_period_         ;
+  double min_improvement_period_     ;
+  double max_improvement_period_     ;
+  double sdf_resolution_             ;
+  double sdf_truncation_             ;
+  double otg_max_jerk_               ;
+  double otg_max_deviation_          ;
+  double totg_path_tolerance_        ;
+  double totg_resample_dt_           ;
+  double streaming_horizon_          ;
+  double swept_volume_cell_size_     ;
+  double swept_volume_margin_        ;
+  double check_horizon_              ;
+  double prediction_horizon_         ;
+  double prediction_step_            ;
+
+  unsigned int world_version_        ;
+  unsigned int last_world_version_   ;
+  unsigned int octree_version_       ;
+  unsigned int speculative_octree_version_;
 
   ros::WallTime tic_trj_;
+  ros::WallTime last_replanning_time_;
 
   ReplannerBasePtr                          replanner_                   ;
   Eigen::VectorXd                           current_configuration_       ;
@@ -98,10 +156,38 @@ protected:
   moveit_msgs::PlanningScene                planning_scene_msg_benchmark_;
 
   std::string obj_type_                ;
+  std::string model_frame_             ;
+  std::string time_parameterization_   ;
+  std::vector<std::string> joint_names_;
   std::vector<double> spawn_instants_  ;
   std::vector<std::string> obj_ids_    ;
   std::vector<Eigen::VectorXd> obj_pos_;
 
+  std::deque<double> replanning_latencies_;
+  std::vector<double> speculative_offsets_;
+  std::vector<CollisionCheckerPtr> speculative_checkers_;
+
+  /* Pools of sequential checkers used to check many connections at once (batch_checks) */
+  BatchCollisionCheckerPtr batch_checker_cc_        ;
+  BatchCollisionCheckerPtr batch_checker_replanning_;
+  BatchCollisionCheckerPtr batch_checker_static_    ;
+
+  DistanceFieldPtr distance_field_;
+  std::vector<double> sdf_workspace_lb_;
+  std::vector<double> sdf_workspace_ub_;
+  std::vector<double> sdf_spheres_;
+  std::vector<std::string> sdf_sphere_links_;
+
+  /* Octree of the sensors, shared read-only by the planning scenes of the checkers (octomap_updates) */
+  std::shared_ptr<const octomap::OcTree> octree_;
+  moveit_msgs::OctomapWithPose octomap_msg_;
+
+  /* Static/dynamic split: the objects in the scene when the query starts are static until they move */
+  CollisionCheckerPtr checker_static_ ;
+  CollisionCheckerPtr checker_dynamic_;
+  std::vector<std::string> dynamic_objects_;
+  std::map<std::string,moveit_msgs::CollisionObject> static_objects_;
+
   std::thread display_thread_   ;
   std::thread trj_exec_thread_  ;
   std::thread col_check_thread_ ;
@@ -109,6 +195,15 @@ protected:
   std::thread benchmark_thread_ ;
   std::thread replanning_thread_;
 
+  /* The threads are launched by the first run() which needs them and stay alive until the manager is destroyed:
+   * each run() starts a query which all of them serve, the query ends when all of them have returned from it */
+  std::mutex query_mtx_;
+  std::condition_variable query_cv_;
+  unsigned int query_id_;
+  unsigned int n_threads_;
+  unsigned int running_threads_;
+  bool shutdown_;
+
   std::mutex trj_mtx_         ;
   std::mutex paths_mtx_       ;
   std::mutex scene_mtx_       ;
@@ -124,10 +219,20 @@ protected:
   ros::Publisher obj_pose_pub_       ;
   ros::Publisher text_overlay_pub_   ;
   ros::Publisher unscaled_target_pub_;
+  ros::Publisher chunk_pub_          ;
+  ros::Publisher unscaled_chunk_pub_ ;
 
   std::string obs_pose_topic_             ;
   std::string joint_target_topic_         ;
   std::string unscaled_joint_target_topic_;
+  std::string chunk_topic_                ;
+  std::string unscaled_chunk_topic_       ;
+  std::string shared_memory_name_         ;
+  int shared_memory_capacity_             ;
+
+  /* Joint targets in shared memory for co-located controllers (shared_memory_target), written by the trajectory execution thread */
+  SharedJointTargetPtr shared_target_;
+  SharedJointTarget::Target shared_target_buffer_;
   std::string which_link_display_path_    ;
 
   ros::ServiceClient add_obj_               ;
@@ -138,6 +243,9 @@ protected:
   virtual void overrideCallback(const std_msgs::Int64ConstPtr& msg, const std::string& override_name);
   virtual void subscribeTopicsAndServices();
   virtual bool replan();
+
+  /* Called by the replanning thread at the end of each cycle, with the time left before the next one (nothing to do by default) */
+  virtual void replanningIdleTime(const double& available_time);
   virtual void fromParam();
   virtual void downloadPathCost();
   virtual void updateSharedPath();
@@ -150,8 +258,71 @@ protected:
   virtual void benchmarkThread();
   virtual void spawnObjectsThread();
   virtual void trajectoryExecutionThread();
+  virtual void launchThreads();
+  void launchThread(std::thread& thread, const std::function<void()>& body, const double& delay = 0.0);
+  void serveQueries(const std::function<void()>& body, const double& delay, const unsigned int& last_query);
+  void shutdownThreads();
+  void initChunk(trajectory_msgs::JointTrajectory& chunk);
+  void fillChunk(trajectory_msgs::JointTrajectory& chunk, const double& velocity_scaling);
+  void writeSharedTarget();
   virtual double readScalingTopics();
+  virtual double computeTimeShift();
+  void addReplanningLatency(const double& replanning_duration);
+  double replanningLatency();
+  double adaptiveDtReplan(const double& dt_replan_max);
+  virtual bool replanningDemanded(const bool path_obstructed);
+  virtual void updateReplanningScheduler(const bool path_improved);
+  virtual bool speculativeReplan(bool& success);
+
+  /* Replanner on path from configuration, with its own solver. The managers which do not override it disable speculative_replanning */
+  virtual ReplannerBasePtr speculativeReplanner(Eigen::VectorXd& configuration, PathPtr& path);
+  TreeSolverPtr cloneSolver(const CollisionCheckerPtr& checker);
+
+  /* solver_ is used by the replanning thread: the other threads clone their own prototype before it starts */
+  static TreeSolverPtr cloneSolver(const TreeSolverPtr& solver, const CollisionCheckerPtr& checker);
   virtual PathPtr trjPath(const PathPtr& path);
+
+  /* Waypoints every resolution only where the speed along the path changes: near the start, the end and the corners,
+   * within the distance needed to accelerate to (or decelerate from) the max speed of each segment given the joint limits.
+   * Straight segments travelled at max speed keep only their end points */
+  PathPtr adaptiveResample(const PathPtr& path, const double& resolution);
+  void initStaticDynamicSplit(const moveit_msgs::PlanningScene& scene);
+  bool splitWorld(const moveit_msgs::PlanningSceneWorld& world, moveit_msgs::PlanningScene& dynamic_scene_msg, const bool& octree_changed);
+  std::vector<bool> staticValidity(const PathPtr& path);
+  bool checkPathDynamic(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx,
+                        const CollisionCheckerPtr& checker, const std::vector<bool>& static_validity);
+  bool checkConnectionsFromConf(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx, const CollisionCheckerPtr& checker,
+                                const std::vector<unsigned int>& conn_ids, const std::vector<bool>& static_validity,
+                                const bool& stop_at_obstruction = false);
+  bool updateOctree(moveit_msgs::OctomapWithPose& octomap);
+  Eigen::Isometry3d octreePose(const planning_scene::PlanningSceneConstPtr& scene);
+  void applyOctree(const CollisionCheckerPtr& checker, const bool& octree_changed);
+  void applyOctree(const BatchCollisionCheckerPtr& batch_checker, const bool& octree_changed);
+  void setWorldMsg(const CollisionCheckerPtr& checker, const moveit_msgs::PlanningScene& msg, const bool& octree_changed);
+  void setWorldMsg(const BatchCollisionCheckerPtr& batch_checker, const moveit_msgs::PlanningScene& msg, const bool& octree_changed);
+
+  /* Applies the scene diff to the checkers of the replanner, with scene_mtx_ locked */
+  virtual void updateReplanningCheckers(const bool& octree_changed);
+  BatchCollisionCheckerPtr batchChecker(const planning_scene::PlanningScenePtr& planning_scene, const CollisionCheckerPtr& checker);
+  bool checkPathBatch(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx, const BatchCollisionCheckerPtr& batch_checker);
+  std::vector<double> connectionTimes(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx, const double& time_to_end);
+  void updatePredictedCheckers(const ObstaclePredictorPtr& predictor, const moveit_msgs::PlanningSceneWorld& world,
+                               std::vector<CollisionCheckerPtr>& checkers, const bool& octree_changed);
+  bool checkPathPredicted(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx, const std::vector<double>& times,
+                          const ObstaclePredictorPtr& predictor, const std::vector<CollisionCheckerPtr>& checkers);
+  std::vector<unsigned int> scheduleConnections(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx,
+                                                const std::vector<unsigned int>& conn_ids, const double& time_to_end,
+                                                const unsigned long& cycle, std::vector<bool>& pending);
+  std::vector<unsigned int> prioritizeConnections(const PathPtr& path, const SweptVolumeGridPtr& swept_volumes, const std::vector<unsigned int>& conn_ids,
+                                                  const std::vector<Eigen::AlignedBox3d>& changed_regions,
+                                                  const std::map<std::string,moveit_msgs::CollisionObject>& world_objects);
+  void checkCurrentPath(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx, const double& time_to_end,
+                        const ObstaclePredictorPtr& predictor, const std::vector<CollisionCheckerPtr>& predicted_checkers,
+                        const SweptVolumeGridPtr& swept_volumes, const std::vector<Eigen::AlignedBox3d>& changed_regions,
+                        const std::map<std::string,moveit_msgs::CollisionObject>& world_objects, const std::vector<bool>& static_validity,
+                        unsigned long& cycle, std::vector<bool>& pending, bool& full_check);
+  std::vector<Eigen::AlignedBox3d> changedRegions(const moveit_msgs::PlanningSceneWorld& world, std::map<std::string,moveit_msgs::CollisionObject>& world_objects,
+                                                  const bool& octree_changed, Eigen::AlignedBox3d& octree_region);
   Eigen::Vector3d forwardIk(const Eigen::VectorXd& conf, const std::string& last_link, const MoveitUtils& util);
   Eigen::Vector3d forwardIk(const Eigen::VectorXd& conf, const std::string& last_link, const MoveitUtils& util, geometry_msgs::Pose &pose);
 
@@ -176,7 +347,7 @@ public:
   ReplannerManagerBase(const PathPtr &current_path,
                        const TreeSolverPtr &solver,
                        const ros::NodeHandle &nh);
-  ~ReplannerManagerBase();
+  virtual ~ReplannerManagerBase();
 
   void setGroupName(const std::string& group_name)
   {
@@ -197,6 +368,12 @@ public:
     return pnt;
   }
 
+  //nullptr if shared_memory_target is false. With an empty shared_memory/name it is local to the process and can be read through this pointer
+  SharedJointTargetPtr getSharedJointTarget()
+  {
+    return shared_target_;
+  }
+
   trajectory_msgs::JointTrajectoryPoint getUnscaledJointTarget()
   {
     trj_mtx_.lock();
@@ -226,6 +403,10 @@ public:
     return goal_reached_;
   }
 
+  /* New query on the same manager, to be called when the previous one is over or stopped */
+  virtual bool reset(const PathPtr& current_path, const Eigen::VectorXd& goal_conf);
+
+  /* Wait for the end of the current query, the threads stay alive for the next one */
   virtual bool joinThreads();
   virtual bool stop();
   virtual bool run();
@@ -0,0 +1,36 @@
+#ifndef REPLANNER_MANAGER_PORTFOLIO_H__
+#define REPLANNER_MANAGER_PORTFOLIO_H__
+
+#include <replanners_lib/replanner_managers/replanner_manager_MPRRT.h>
+#include <replanners_lib/replanners/portfolio.h>
+
+namespace pathplan
+{
+class ReplannerManagerPortfolio;
+typedef std::shared_ptr<ReplannerManagerPortfolio> ReplannerManagerPortfolioPtr;
+
+// The replanned path is spliced on the current one as in MPRRT, since the portfolio winner may be any replanner
+class ReplannerManagerPortfolio: public ReplannerManagerMPRRT
+{
+protected:
+  int n_threads_portfolio_;
+  std::vector<std::string> portfolio_replanners_;
+
+  bool haveToReplan(const bool path_obstructed) override;
+  void initReplanner() override;
+  void updateReplanningCheckers(const bool& octree_changed) override;
+  void portfolioParams();
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  ReplannerManagerPortfolio(const PathPtr &current_path,
+                            const TreeSolverPtr &solver,
+                            const ros::NodeHandle &nh);
+
+  ~ReplannerManagerPortfolio();
+};
+
+}
+
+#endif // REPLANNER_MANAGER_PORTFOLIO_H__
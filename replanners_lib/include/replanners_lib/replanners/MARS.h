@@ -2,6 +2,8 @@
 #define MARS_H__
 #include <replanners_lib/replanners/replanner_base.h>
 #include <graph_core/graph/net.h>
+#include <unordered_set>
+#include <queue>
 
 namespace pathplan
 {
@@ -44,6 +46,7 @@ protected:
   double time_replanning_;
   double available_time_;
   double pathSwitch_max_time_;
+  ros::WallTime tic_replanning_;
   double pathSwitch_cycle_time_mean_;
   double time_percentage_variability_;
 
@@ -77,6 +80,7 @@ protected:
   void optimizePath(PathPtr &connecting_path, const double &max_time);
   void simplifyAdmissibleOtherPaths(const PathPtr& current_solution_path, const NodePtr &start_node, const std::vector<PathPtr>& reset_other_paths);
   bool mergePathToTree(const PathPtr &path);
+  bool purgeSubtree(const NodePtr& node, const std::unordered_set<Node*>& kept_nodes, std::unordered_set<Node*>& tree_nodes, unsigned int& removed_nodes);
   void convertToSubtreeSolution(const PathPtr& net_solution, const std::vector<NodePtr>& black_nodes);
 
   bool findValidSolution(const std::multimap<double,std::vector<ConnectionPtr>> &map, const double& cost2beat, std::vector<ConnectionPtr>& solution, double &cost, bool verbose = false);
@@ -113,6 +117,11 @@ public:
     return other_paths_;
   }
 
+  NodePtr getPathsStart()
+  {
+    return paths_start_;
+  }
+
   void setVerbosity(const bool& verbose)
   {
     verbose_ = verbose;
@@ -235,6 +244,8 @@ public:
   }
 
   bool simplifyReplannedPath(const double& distance);
+  unsigned int compactTree(const unsigned int& node_budget, const unsigned int& n_other_paths_to_keep, const std::vector<NodePtr>& white_list = {},
+                           const double& max_time = std::numeric_limits<double>::infinity());
 
   virtual bool pathSwitch(const PathPtr& current_path, const NodePtr& path1_node, PathPtr &new_path);
   virtual bool informedOnlineReplanning(const double &max_time  = std::numeric_limits<double>::infinity());
@@ -0,0 +1,83 @@
+#ifndef PORTFOLIO_H__
+#define PORTFOLIO_H__
+#include <replanners_lib/replanners/replanner_base.h>
+#include <replanners_lib/replanners/MARS.h>
+#include <replanners_lib/replanners/DRRT.h>
+#include <replanners_lib/replanners/DRRTStar.h>
+#include <replanners_lib/replanners/anytimeDRRT.h>
+#include <replanners_lib/replanners/MPRRT.h>
+#include <graph_core/informed_sampler.h>
+#include <numeric>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+
+//Runs several replanners concurrently on the same current path and keeps the best solution
+
+namespace pathplan
+{
+class ReplannerPortfolio;
+typedef std::shared_ptr<ReplannerPortfolio> ReplannerPortfolioPtr;
+
+class ReplannerPortfolio: public ReplannerBase
+{
+protected:
+  unsigned int n_threads_;
+  std::vector<std::string> replanners_names_;
+  std::vector<unsigned int> threads_;       // threads assigned to each replanner
+  std::vector<unsigned int> wins_;          // number of replanning cycles in which each replanner found the first valid solution
+  std::vector<unsigned int> trials_;        // number of replanning cycles each replanner took part in
+  std::vector<CollisionCheckerPtr> checkers_; // one per instance, kept across the cycles and updated with the scene diffs
+  std::vector<PathPtr> other_paths_;        // solutions of the replanners which lost the last cycle, for MARS
+  std::string last_winner_;
+
+  std::vector<PathPtr> otherPathsFromStart(const CollisionCheckerPtr& checker);
+  ReplannerBasePtr createReplanner(const std::string& name, const unsigned int& n_threads, const CollisionCheckerPtr& checker);
+  void allocateThreads();
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  ReplannerPortfolio(Eigen::VectorXd& current_configuration,
+                     PathPtr& current_path,
+                     const double& max_time,
+                     const TreeSolverPtr& solver,
+                     const std::vector<std::string>& replanners_names,
+                     const unsigned int& n_threads = 1);
+
+  std::vector<std::string> getReplannersNames() const
+  {
+    return replanners_names_;
+  }
+
+  std::vector<unsigned int> getWins() const
+  {
+    return wins_;
+  }
+
+  std::vector<unsigned int> getTrials() const
+  {
+    return trials_;
+  }
+
+  std::vector<unsigned int> getThreads() const
+  {
+    return threads_;
+  }
+
+  std::string getLastWinner() const
+  {
+    return last_winner_;
+  }
+
+  /* The scene changes of checker_ must be applied to these ones too */
+  std::vector<CollisionCheckerPtr> getCheckers() const
+  {
+    return checkers_;
+  }
+
+  bool replan() override;
+};
+}
+
+#endif // PORTFOLIO_H
@@ -2,6 +2,8 @@
 #define REPLANNERBASE_H__
 
 #include <ros/ros.h>
+#include <atomic>
+#include <unordered_map>
 #include <eigen3/Eigen/Core>
 #include <graph_core/util.h>
 #include <graph_core/metrics.h>
@@ -13,6 +15,7 @@
 #include <graph_core/graph/graph_display.h>
 #include <graph_core/solvers/tree_solver.h>
 #include <graph_core/solvers/path_solver.h>
+#include <replanners_lib/batch_collision_checker.h>
 
 namespace pathplan
 {
@@ -28,6 +31,7 @@ protected:
   TreeSolverPtr solver_;
   MetricsPtr metrics_;
   CollisionCheckerPtr checker_;
+  BatchCollisionCheckerPtr batch_checker_;
   Eigen::VectorXd lb_;
   Eigen::VectorXd ub_;
   DisplayPtr disp_;
@@ -37,6 +41,7 @@ protected:
   bool success_;
   bool verbose_;
   double max_time_;
+  std::atomic<bool> stop_;
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -74,6 +79,13 @@ public:
     max_time_ = max_time;
   }
 
+  /* Asks replan() (possibly running in another thread) to return as soon as possible with the best solution found so far,
+   * as if its time were over. It holds until cleared */
+  void stop(const bool& stop = true)
+  {
+    stop_ = stop;
+  }
+
   virtual void setVerbosity(const bool& verbose)
   {
     verbose_ = verbose;
@@ -110,6 +122,12 @@ public:
       replanned_path_->setChecker(checker);
   }
 
+  /* Pool of checkers with the same scene of checker_, used to check many connections at once (none by default) */
+  void setBatchChecker(const BatchCollisionCheckerPtr& batch_checker)
+  {
+    batch_checker_ = batch_checker;
+  }
+
   void setDisp(const DisplayPtr &disp)
   {
     disp_ = disp;
@@ -131,6 +149,10 @@ public:
   }
 
   virtual bool replan() = 0;
+
+  /* Copy of path and of its whole tree (nodes, connections and costs) checked by checker, so that a replanner can work on it
+   * concurrently with the original one. If the path is not made of tree connections, the tree of the copy is the path only */
+  static PathPtr clonePathWithTree(const PathPtr& path, const CollisionCheckerPtr& checker, const double& max_distance);
 };
 }
 
@@ -0,0 +1,79 @@
+#ifndef SDF_COLLISION_CHECKER_H__
+#define SDF_COLLISION_CHECKER_H__
+
+#include <graph_core/collision_checker.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <geometric_shapes/shape_operations.h>
+#include <replanners_lib/distance_field.h>
+
+namespace pathplan
+{
+class SdfCollisionChecker;
+typedef std::shared_ptr<SdfCollisionChecker> SdfCollisionCheckerPtr;
+
+/* Collision checker based on a DistanceField of the world and a sphere model of the robot links.
+ * A configuration is free when every sphere is farther than its radius from the world.
+ * Along a connection the clearance bounds how far the robot can move before touching an obstacle,
+ * so checkPath() advances by steps proportional to the clearance (never shorter than min_distance_).
+ * The motion of a sphere per unit of joint displacement is bounded by the lever arms between each joint and the sphere,
+ * computed along the kinematic chain and independent of the configuration.
+ * The bodies attached to the robot get a sphere per shape, on the link they are attached to.
+ * Self collisions (optional) are checked by MoveIt with the planning scene. Along a connection the self distance bounds
+ * the step in the same way, two bodies approaching at most at twice the speed of the fastest link.
+ * The distance field is shared among clones and copied by a checker before its first update, so it is never modified
+ * while shared. */
+class SdfCollisionChecker: public CollisionChecker
+{
+protected:
+  planning_scene::PlanningScenePtr planning_scene_;
+  std::string group_name_;
+  robot_state::RobotStatePtr state_;
+  const robot_state::JointModelGroup* jmg_;
+
+  std::vector<const robot_model::LinkModel*> robot_sphere_links_;
+  Eigen::Matrix4Xd robot_spheres_;
+  std::vector<const robot_model::LinkModel*> sphere_links_; //robot spheres followed by the attached bodies ones
+  Eigen::Matrix4Xd spheres_; //x,y,z offset in the link frame and radius
+  Eigen::MatrixXd lever_arms_; //number of spheres x number of joints
+  Eigen::MatrixXd link_lever_arms_; //number of links with geometry x number of joints, whole links
+
+  DistanceFieldPtr distance_field_;
+  bool owns_distance_field_;
+  bool check_self_collisions_;
+
+  void computeLeverArms();
+  void updateAttachedBodies();
+  double clearance(const Eigen::VectorXd& configuration, Eigen::VectorXd& spheres_clearance);
+  bool checkSelfCollision(const Eigen::VectorXd& configuration);
+  double selfDistance(const Eigen::VectorXd& configuration);
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  /* If sphere_links is empty every link of the group is approximated by the sphere circumscribing its collision geometry */
+  SdfCollisionChecker(const planning_scene::PlanningScenePtr& planning_scene,
+                      const std::string& group_name,
+                      const DistanceFieldPtr& distance_field,
+                      const std::vector<std::string>& sphere_links = {},
+                      const Eigen::Matrix4Xd& spheres = Eigen::Matrix4Xd(4,0),
+                      const bool& check_self_collisions = true,
+                      const double& min_distance = 0.01);
+
+  /* Bound of the displacement of the points of link within reach from its origin per unit displacement of each joint of jmg */
+  static Eigen::RowVectorXd leverArms(const robot_state::JointModelGroup* jmg, const robot_model::LinkModel* link, const double& reach);
+
+  void setPlanningSceneMsg(const moveit_msgs::PlanningScene& msg) override;
+
+  bool check(const Eigen::VectorXd& configuration) override;
+  bool checkPath(const Eigen::VectorXd& configuration1, const Eigen::VectorXd& configuration2) override;
+
+  CollisionCheckerPtr clone() override;
+
+  planning_scene::PlanningScenePtr getPlanningScene() override
+  {
+    return planning_scene_;
+  }
+};
+}
+
+#endif // SDF_COLLISION_CHECKER_H
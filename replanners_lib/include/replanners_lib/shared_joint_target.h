@@ -0,0 +1,112 @@
+#ifndef SHARED_JOINT_TARGET_H__
+#define SHARED_JOINT_TARGET_H__
+
+#include <new>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include <fcntl.h>
+#include <cstring>
+#include <unistd.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace pathplan
+{
+class SharedJointTarget;
+typedef std::shared_ptr<SharedJointTarget> SharedJointTargetPtr;
+
+/* Joint targets of the trajectory execution thread in shared memory, for controllers running on the same host.
+ * Memory layout (native endianness, 64 bytes aligned):
+ * header: magic, version, dof, capacity, number of targets written
+ * latest slot, followed by capacity ring slots; each slot: sequence, stamp, positions, velocities, unscaled positions, unscaled velocities.
+ * Each slot is a seqlock: the writer makes the sequence odd, copies the target and makes it even again, so writing never waits
+ * and a reader retries only if its copy overlapped a write. The latest slot gives the current target, the ring slots let a
+ * reader which is slower than the writer catch up on the last capacity targets.
+ * With an empty name the memory is local to the process (stand-in for tests, readers use the same object). */
+class SharedJointTarget
+{
+public:
+  struct Target
+  {
+    double stamp;
+    std::vector<double> positions;
+    std::vector<double> velocities;
+    std::vector<double> unscaled_positions;
+    std::vector<double> unscaled_velocities;
+  };
+
+protected:
+  struct Header
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t dof;
+    uint32_t capacity;
+    std::atomic<uint64_t> n_written;
+  };
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,"the seqlock needs lock-free 64 bit atomics");
+
+  std::string name_;
+  bool owner_;
+  void* memory_;
+  size_t size_;
+  size_t slot_size_;
+
+  Header* header_;
+  unsigned int dof_;
+  unsigned int capacity_;
+
+  static size_t slotSize(const unsigned int& dof);
+  static size_t memorySize(const unsigned int& dof, const unsigned int& capacity);
+
+  char* slot(const uint64_t& idx) const; //idx 0 is the latest slot, ring slots from 1
+  static void writeSlot(char* slot, const uint64_t& sequence, const Target& target, const unsigned int& dof);
+  static bool readSlot(const char* slot, uint64_t& sequence, Target& target, const unsigned int& dof);
+
+public:
+  /* Writer: creates the memory (replacing a previous one with the same name), it is removed on destruction */
+  SharedJointTarget(const std::string& name, const unsigned int& dof, const unsigned int& capacity);
+
+  /* Reader: opens the memory created by a writer */
+  SharedJointTarget(const std::string& name);
+
+  ~SharedJointTarget();
+
+  SharedJointTarget(const SharedJointTarget&) = delete;
+  SharedJointTarget& operator=(const SharedJointTarget&) = delete;
+
+  void write(const Target& target);
+
+  /* False if nothing has been written yet */
+  bool readLatest(Target& target) const;
+
+  /* Target number idx (from 0), false if not written yet or already overwritten in the ring (then idx is moved to the oldest one available) */
+  bool read(uint64_t& idx, Target& target) const;
+
+  uint64_t getWrittenNumber() const
+  {
+    return header_->n_written.load(std::memory_order_acquire);
+  }
+
+  unsigned int getDof() const
+  {
+    return dof_;
+  }
+
+  unsigned int getCapacity() const
+  {
+    return capacity_;
+  }
+
+  const std::string& getName() const
+  {
+    return name_;
+  }
+};
+}
+
+#endif // SHARED_JOINT_TARGET_H
@@ -0,0 +1,72 @@
+#ifndef SWEPT_VOLUME_GRID_H__
+#define SWEPT_VOLUME_GRID_H__
+
+#include <map>
+#include <unordered_map>
+#include <Eigen/Geometry>
+#include <octomap/OcTree.h>
+#include <graph_core/graph/path.h>
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit_msgs/PlanningSceneWorld.h>
+
+namespace pathplan
+{
+class SweptVolumeGrid;
+typedef std::shared_ptr<SweptVolumeGrid> SweptVolumeGridPtr;
+
+/* Spatial hash of the workspace volume swept by the connections of a path.
+ * Each connection is sampled in the joint space, the bounding boxes of the links with geometry (inflated by margin)
+ * are computed via forward kinematics at each sample and the connection is stored in all the cells they overlap.
+ * The connections near a changed region of the world are then found looking up only the cells of that region. */
+class SweptVolumeGrid
+{
+protected:
+  robot_state::RobotStatePtr state_;
+  const robot_state::JointModelGroup* jmg_;
+  std::vector<const robot_model::LinkModel*> links_;
+
+  double cell_size_;
+  double resolution_;
+  double margin_;
+
+  std::unordered_map<int64_t,std::vector<unsigned int>> cells_;
+  std::vector<std::vector<Eigen::AlignedBox3d>> conn_boxes_;
+
+  int64_t key(const Eigen::Vector3i& cell) const;
+  Eigen::Vector3i cell(const Eigen::Vector3d& point) const;
+  void addBox(const Eigen::AlignedBox3d& box, const unsigned int& conn_idx);
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  SweptVolumeGrid(const robot_model::RobotModelConstPtr& robot_model,
+                  const std::string& group_name,
+                  const double& cell_size = 0.1,
+                  const double& resolution = 0.05,
+                  const double& margin = 0.05);
+
+  void setPath(const PathPtr& path);
+
+  //Sorted indices of the connections whose swept volume may overlap one of the boxes
+  std::vector<unsigned int> connectionsInRegions(const std::vector<Eigen::AlignedBox3d>& regions) const;
+
+  //Lower bound of the workspace distance between the swept volume of the connection and the boxes (infinite if there are no boxes)
+  double distance(const unsigned int& conn_idx, const std::vector<Eigen::AlignedBox3d>& boxes) const;
+
+  /* Box of the object in the planning frame of scene: the shape poses are relative to the object pose, which is expressed in
+   * header.frame_id (taken as the planning frame if scene is nullptr) */
+  static Eigen::AlignedBox3d objectBox(const moveit_msgs::CollisionObject& object, const planning_scene::PlanningSceneConstPtr& scene = nullptr);
+
+  //Bounding box of the known space of the octree at pose
+  static Eigen::AlignedBox3d octreeBox(const octomap::OcTree& octree, const Eigen::Isometry3d& pose);
+
+  /* Boxes of the objects added, moved (old and new pose) or removed with respect to objects, which is updated */
+  static std::vector<Eigen::AlignedBox3d> changedRegions(const moveit_msgs::PlanningSceneWorld& world,
+                                                         std::map<std::string,moveit_msgs::CollisionObject>& objects,
+                                                         const planning_scene::PlanningSceneConstPtr& scene = nullptr);
+};
+}
+
+#endif // SWEPT_VOLUME_GRID_H
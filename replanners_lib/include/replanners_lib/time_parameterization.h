@@ -0,0 +1,98 @@
+#ifndef TIME_PARAMETERIZATION_H__
+#define TIME_PARAMETERIZATION_H__
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/trajectory_processing/iterative_time_parameterization.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <moveit/trajectory_processing/iterative_spline_parameterization.h>
+#include <replanners_lib/online_trajectory_generator.h>
+
+namespace pathplan
+{
+class TimeParameterizer;
+typedef std::shared_ptr<TimeParameterizer> TimeParameterizerPtr;
+
+/* Time parameterization of the waypoints of a trajectory (time stamps, velocities and accelerations).
+ * max_velocity and max_acceleration are the limits of the active joints of the group, cached by the caller;
+ * the MoveIt algorithms ignore them and read the limits from the robot model at each call. */
+class TimeParameterizer
+{
+protected:
+  std::string name_;
+
+public:
+  TimeParameterizer(const std::string& name): name_(name){}
+  virtual ~TimeParameterizer() = default;
+
+  virtual bool computeTimeStamps(robot_trajectory::RobotTrajectory& trj, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration) = 0;
+
+  const std::string& getName() const
+  {
+    return name_;
+  }
+
+  /* iterative_parabolic, iterative_spline, time_optimal or trapezoidal, nullptr if unknown.
+   * path_tolerance and resample_dt are used only by time_optimal */
+  static TimeParameterizerPtr fromName(const std::string& name, const double& path_tolerance = 0.1, const double& resample_dt = 0.1);
+};
+
+/* MoveIt IterativeParabolicTimeParameterization */
+class IterativeParabolicParameterizer: public TimeParameterizer
+{
+protected:
+  trajectory_processing::IterativeParabolicTimeParameterization iptp_;
+
+public:
+  IterativeParabolicParameterizer(): TimeParameterizer("iterative_parabolic"){}
+
+  bool computeTimeStamps(robot_trajectory::RobotTrajectory& trj, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration) override
+  {
+    return iptp_.computeTimeStamps(trj);
+  }
+};
+
+/* MoveIt IterativeSplineParameterization: smoother (continuous acceleration) and slower to compute */
+class IterativeSplineParameterizer: public TimeParameterizer
+{
+protected:
+  trajectory_processing::IterativeSplineParameterization isp_;
+
+public:
+  IterativeSplineParameterizer(): TimeParameterizer("iterative_spline"), isp_(true){}
+
+  bool computeTimeStamps(robot_trajectory::RobotTrajectory& trj, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration) override
+  {
+    return isp_.computeTimeStamps(trj);
+  }
+};
+
+/* MoveIt TimeOptimalTrajectoryGeneration: shortest duration, the trajectory is resampled every resample_dt seconds.
+ * The corners of the path are blended, so the executed trajectory deviates from the checked path up to path_tolerance
+ * (joint space distance): keep it below the collision checker resolution */
+class TimeOptimalParameterizer: public TimeParameterizer
+{
+protected:
+  trajectory_processing::TimeOptimalTrajectoryGeneration totg_;
+
+public:
+  TimeOptimalParameterizer(const double& path_tolerance = 0.1, const double& resample_dt = 0.1):
+    TimeParameterizer("time_optimal"), totg_(path_tolerance,resample_dt){}
+
+  bool computeTimeStamps(robot_trajectory::RobotTrajectory& trj, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration) override
+  {
+    return totg_.computeTimeStamps(trj);
+  }
+};
+
+/* Single forward/backward pass with trapezoidal speed profiles along the path (see OnlineTrajectoryGenerator::timePath).
+ * It uses the given limits, it is the fastest to compute; coincident waypoints are removed */
+class TrapezoidalParameterizer: public TimeParameterizer
+{
+public:
+  TrapezoidalParameterizer(): TimeParameterizer("trapezoidal"){}
+
+  bool computeTimeStamps(robot_trajectory::RobotTrajectory& trj, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration) override;
+};
+}
+
+#endif // TIME_PARAMETERIZATION_H
@@ -11,12 +11,13 @@
 #include <graph_core/local_informed_sampler.h>
 #include <eigen_conversions/eigen_msg.h>
 #include <moveit/robot_trajectory/robot_trajectory.h>
+#include <future>
+#include <random>
 #include <unordered_map>
-#include <moveit/trajectory_processing/iterative_time_parameterization.h>
-#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
-#include <moveit/trajectory_processing/iterative_spline_parameterization.h>
 #include <moveit_planning_helper/spline_interpolator.h>
 #include <replanners_lib/moveit_utils.h>
+#include <replanners_lib/time_parameterization.h>
+#include <replanners_lib/online_trajectory_generator.h>
 
 #define COMMENT(...) ROS_LOG(::ros::console::levels::Debug, ROSCONSOLE_DEFAULT_NAME, __VA_ARGS__);
 
@@ -36,6 +37,18 @@ protected:
   planning_scene::PlanningScenePtr planning_scene_;  //REMOVE
   std::string group_name_;
   MoveitUtilsPtr moveit_utils_;
+  OnlineTrajectoryGeneratorPtr otg_;
+  TimeParameterizerPtr time_parameterizer_;
+  double parameterization_time_;
+
+  //Limits of the active joints of the group, read once from the robot model
+  Eigen::VectorXd max_velocity_;
+  Eigen::VectorXd max_acceleration_;
+
+  void loadJointLimits();
+
+  //nullptr if pnt cannot be spliced onto the path, trj_ is not modified then
+  robot_trajectory::RobotTrajectoryPtr fromPath2TrjOnline(const trajectory_msgs::JointTrajectoryPointPtr& pnt);
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -70,6 +83,40 @@ public:
     return path_;
   }
 
+  //If set, fromPath2Trj splices the current state onto the path with the online generator instead of timing it with the time parameterizer,
+  //which is still used when the state cannot be spliced
+  void setOnlineTrajectoryGenerator(const OnlineTrajectoryGeneratorPtr& otg)
+  {
+    otg_ = otg;
+  }
+
+  //Algorithm used by fromPath2Trj, IterativeParabolicParameterizer by default
+  void setTimeParameterizer(const TimeParameterizerPtr& time_parameterizer)
+  {
+    if(time_parameterizer == nullptr)
+      throw std::runtime_error("time parameterizer is nullptr");
+
+    time_parameterizer_ = time_parameterizer;
+  }
+
+  TimeParameterizerPtr getTimeParameterizer()
+  {
+    return time_parameterizer_;
+  }
+
+  //Computation time of the last fromPath2Trj [s]
+  double getParameterizationTime()
+  {
+    return parameterization_time_;
+  }
+
+  //Velocity and acceleration limits of the active joints of the group (1.0 if not bounded, as IterativeParabolicTimeParameterization does)
+  void jointLimits(Eigen::VectorXd& max_velocity, Eigen::VectorXd& max_acceleration) const
+  {
+    max_velocity     = max_velocity_    ;
+    max_acceleration = max_acceleration_;
+  }
+
   robot_trajectory::RobotTrajectoryPtr getTrj()
   {
     if(trj_ == nullptr)
@@ -78,8 +125,24 @@ public:
     return trj_;
   }
 
-  PathPtr computePath(const NodePtr &start_node, const NodePtr &goal_node, const TreeSolverPtr& solver, const bool& optimize = true, const double &max_time = std::numeric_limits<double>::infinity());
-  PathPtr computePath(const Eigen::VectorXd &start_conf, const Eigen::VectorXd &goal_conf, const TreeSolverPtr& solver, const bool& optimizePath = true, const double &max_time = std::numeric_limits<double>::infinity());
+  //seed initializes the generator of the optimization, by default it is drawn from std::random_device
+  PathPtr computePath(const NodePtr &start_node, const NodePtr &goal_node, const TreeSolverPtr& solver, const bool& optimize = true, const double &max_time = std::numeric_limits<double>::infinity(),
+                      const unsigned int& seed = std::random_device()());
+  PathPtr computePath(const Eigen::VectorXd &start_conf, const Eigen::VectorXd &goal_conf, const TreeSolverPtr& solver, const bool& optimizePath = true, const double &max_time = std::numeric_limits<double>::infinity(),
+                      const unsigned int& seed = std::random_device()());
+
+  //Runs n_seeds independent solve+optimize concurrently (each one with its own metrics, checker and sampler) and returns the cheapest path. All the paths found are stored in solutions, sorted by cost.
+  //The seeds of the pipelines are consecutive, starting from one drawn from std::random_device
+  PathPtr computePath(const Eigen::VectorXd &start_conf, const Eigen::VectorXd &goal_conf, const TreeSolverPtr& solver, const unsigned int& n_seeds, std::vector<PathPtr>& solutions,
+                      const bool& optimizePath = true, const double &max_time = std::numeric_limits<double>::infinity());
+
+  //Paths at a discrete Frechet distance >= min_distance from the reference paths and from each other. Among n_candidates solutions, the one with the highest distance per node is kept
+  std::vector<PathPtr> computeDiversePaths(const Eigen::VectorXd &start_conf, const Eigen::VectorXd &goal_conf, const TreeSolverPtr& solver, const unsigned int& n_paths,
+                                           const std::vector<PathPtr>& reference_paths = {}, const double& min_distance = 0.0, const unsigned int& n_candidates = 3,
+                                           const bool& optimizePath = true, const double &max_time = std::numeric_limits<double>::infinity());
+
+  static double frechetDistance(const PathPtr& path1, const PathPtr& path2, const double& resolution = 0.05);
+  static std::vector<Eigen::VectorXd> resampleWaypoints(const PathPtr& path, const double& resolution);
 
   robot_trajectory::RobotTrajectoryPtr fromPath2Trj(const trajectory_msgs::JointTrajectoryPointPtr& pnt = nullptr);
   robot_trajectory::RobotTrajectoryPtr fromPath2Trj(const trajectory_msgs::JointTrajectoryPoint& pnt);
@@ -0,0 +1,343 @@
+#include "replanners_lib/analytic_collision_checker.h"
+
+namespace pathplan
+{
+
+static Eigen::Isometry3d fromPoseMsg(const geometry_msgs::Pose& pose)
+{
+  Eigen::Quaterniond q(pose.orientation.w,pose.orientation.x,pose.orientation.y,pose.orientation.z);
+  if(q.norm()<1e-6)
+    q = Eigen::Quaterniond::Identity();
+
+  Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+  T.linear() = q.normalized().toRotationMatrix();
+  T.translation()<<pose.position.x,pose.position.y,pose.position.z;
+
+  return T;
+}
+
+AnalyticCollisionChecker::AnalyticCollisionChecker(const Eigen::Matrix4Xd& robot_spheres,
+                                                   const double& min_distance,
+                                                   const unsigned int& batch_size,
+                                                   const std::string& world_frame):
+  CollisionChecker(min_distance),
+  world_frame_(world_frame),
+  robot_spheres_(robot_spheres),
+  batch_size_(std::max(batch_size,(unsigned int) 1))
+{
+  if(robot_spheres_.cols() == 0)
+  {
+    ROS_ERROR("no robot spheres, the robot is a point");
+    robot_spheres_ = Eigen::Matrix4Xd::Zero(4,1);
+  }
+
+  updateArrays();
+}
+
+void AnalyticCollisionChecker::addSphere(const std::string& id, const Eigen::Vector3d& center, const double& radius)
+{
+  Eigen::Vector4d sphere;
+  sphere<<center,radius;
+
+  objects_[id].spheres.push_back(sphere);
+  updateArrays();
+}
+
+void AnalyticCollisionChecker::addBox(const std::string& id, const Eigen::Vector3d& center, const Eigen::Vector3d& half_extents)
+{
+  Eigen::Matrix<double,6,1> box;
+  box<<center,half_extents.cwiseAbs();
+
+  objects_[id].boxes.push_back(box);
+  updateArrays();
+}
+
+void AnalyticCollisionChecker::removeObject(const std::string& id)
+{
+  objects_.erase(id);
+  object_msgs_.erase(id);
+  updateArrays();
+}
+
+void AnalyticCollisionChecker::clearObjects()
+{
+  objects_.clear();
+  object_msgs_.clear();
+  updateArrays();
+}
+
+void AnalyticCollisionChecker::updateArrays()
+{
+  unsigned int n_spheres = 0;
+  unsigned int n_boxes = 0;
+  for(const std::pair<const std::string,Obstacles>& object:objects_)
+  {
+    n_spheres += object.second.spheres.size();
+    n_boxes   += object.second.boxes  .size();
+  }
+
+  sphere_x_.resize(n_spheres); sphere_y_.resize(n_spheres); sphere_z_.resize(n_spheres); sphere_r_.resize(n_spheres);
+  box_x_ .resize(n_boxes); box_y_ .resize(n_boxes); box_z_ .resize(n_boxes);
+  box_hx_.resize(n_boxes); box_hy_.resize(n_boxes); box_hz_.resize(n_boxes);
+
+  unsigned int is = 0;
+  unsigned int ib = 0;
+  for(const std::pair<const std::string,Obstacles>& object:objects_)
+  {
+    for(const Eigen::Vector4d& s:object.second.spheres)
+    {
+      sphere_x_(is) = s(0); sphere_y_(is) = s(1); sphere_z_(is) = s(2); sphere_r_(is) = s(3);
+      is++;
+    }
+    for(const Eigen::Matrix<double,6,1>& b:object.second.boxes)
+    {
+      box_x_ (ib) = b(0); box_y_ (ib) = b(1); box_z_ (ib) = b(2);
+      box_hx_(ib) = b(3); box_hy_(ib) = b(4); box_hz_(ib) = b(5);
+      ib++;
+    }
+  }
+}
+
+bool AnalyticCollisionChecker::objectPose(const moveit_msgs::CollisionObject& object, Eigen::Isometry3d& pose) const
+{
+  pose = fromPoseMsg(object.pose);
+  if(object.header.frame_id.empty() || object.header.frame_id == world_frame_)
+    return true;
+
+  std::map<std::string,Eigen::Isometry3d>::const_iterator it = frames_.find(object.header.frame_id);
+  if(it == frames_.end())
+    return false;
+
+  pose = it->second*pose;
+  return true;
+}
+
+bool AnalyticCollisionChecker::addCollisionObject(const moveit_msgs::CollisionObject& object, Obstacles& obstacles)
+{
+  if(not object.meshes.empty() || not object.planes.empty())
+    ROS_WARN_STREAM("meshes and planes of object "<<object.id<<" are ignored");
+
+  Eigen::Isometry3d object_pose;
+  if(not objectPose(object,object_pose))
+  {
+    ROS_WARN_STREAM("frame "<<object.header.frame_id<<" of object "<<object.id<<" unknown, the object is ignored");
+    return false;
+  }
+
+  for(unsigned int i=0;i<object.primitives.size() && i<object.primitive_poses.size();i++)
+  {
+    const shape_msgs::SolidPrimitive& primitive = object.primitives.at(i);
+    Eigen::Isometry3d pose = object_pose*fromPoseMsg(object.primitive_poses.at(i));
+
+    Eigen::Vector3d center = pose.translation();
+    Eigen::Matrix3d rot = pose.linear();
+
+    Eigen::Vector3d half_extents;
+    switch(primitive.type)
+    {
+    case shape_msgs::SolidPrimitive::SPHERE:
+    {
+      Eigen::Vector4d sphere;
+      sphere<<center,primitive.dimensions.at(shape_msgs::SolidPrimitive::SPHERE_RADIUS);
+      obstacles.spheres.push_back(sphere);
+      continue;
+    }
+    case shape_msgs::SolidPrimitive::BOX:
+      half_extents<<primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_X),
+          primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_Y),
+          primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_Z);
+      half_extents = 0.5*half_extents;
+      break;
+    case shape_msgs::SolidPrimitive::CYLINDER:
+    case shape_msgs::SolidPrimitive::CONE:
+    {
+      // CYLINDER_HEIGHT == CONE_HEIGHT and CYLINDER_RADIUS == CONE_RADIUS
+      double r = primitive.dimensions.at(shape_msgs::SolidPrimitive::CYLINDER_RADIUS);
+      half_extents<<r,r,0.5*primitive.dimensions.at(shape_msgs::SolidPrimitive::CYLINDER_HEIGHT);
+      break;
+    }
+    default:
+      ROS_WARN_STREAM("primitive type "<<(int) primitive.type<<" of object "<<object.id<<" not supported");
+      return false;
+    }
+
+    // Axis-aligned bounding box of the rotated primitive
+    Eigen::Matrix<double,6,1> box;
+    box<<center,rot.cwiseAbs()*half_extents;
+    obstacles.boxes.push_back(box);
+  }
+
+  return true;
+}
+
+void AnalyticCollisionChecker::setPlanningSceneMsg(const moveit_msgs::PlanningScene& msg)
+{
+  if(not msg.is_diff)
+  {
+    objects_.clear();
+    object_msgs_.clear();
+  }
+
+  if(not msg.is_diff || not msg.fixed_frame_transforms.empty())
+  {
+    frames_.clear();
+    for(const geometry_msgs::TransformStamped& transform:msg.fixed_frame_transforms)
+    {
+      if(transform.header.frame_id != world_frame_)
+        continue;
+
+      Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+      T.linear() = Eigen::Quaterniond(transform.transform.rotation.w,transform.transform.rotation.x,
+                                      transform.transform.rotation.y,transform.transform.rotation.z).normalized().toRotationMatrix();
+      T.translation()<<transform.transform.translation.x,transform.transform.translation.y,transform.transform.translation.z;
+      frames_[transform.child_frame_id] = T;
+    }
+  }
+
+  for(const moveit_msgs::CollisionObject& object:msg.world.collision_objects)
+  {
+    switch(object.operation)
+    {
+    case moveit_msgs::CollisionObject::ADD:
+      objects_[object.id] = Obstacles();
+      object_msgs_[object.id] = {object};
+      addCollisionObject(object,objects_[object.id]);
+      break;
+    case moveit_msgs::CollisionObject::APPEND:
+      object_msgs_[object.id].push_back(object);
+      addCollisionObject(object,objects_[object.id]);
+      break;
+    case moveit_msgs::CollisionObject::MOVE:
+    {
+      // As in MoveIt, only the pose of an existing object changes
+      std::map<std::string,std::vector<moveit_msgs::CollisionObject>>::iterator it = object_msgs_.find(object.id);
+      if(it == object_msgs_.end())
+        break;
+
+      objects_[object.id] = Obstacles();
+      for(moveit_msgs::CollisionObject& moved:it->second)
+      {
+        moved.header = object.header;
+        moved.pose = object.pose;
+        addCollisionObject(moved,objects_[object.id]);
+      }
+      break;
+    }
+    case moveit_msgs::CollisionObject::REMOVE:
+      if(object.id.empty())
+      {
+        objects_.clear();
+        object_msgs_.clear();
+      }
+      else
+      {
+        objects_.erase(object.id);
+        object_msgs_.erase(object.id);
+      }
+      break;
+    default:
+      ROS_WARN_STREAM("operation "<<(int) object.operation<<" on object "<<object.id<<" not supported");
+    }
+  }
+
+  updateArrays();
+}
+
+Eigen::Vector3d AnalyticCollisionChecker::position(const Eigen::VectorXd& configuration) const
+{
+  Eigen::Vector3d p = Eigen::Vector3d::Zero();
+  unsigned int n = std::min((int) configuration.size(),3);
+  p.head(n) = configuration.head(n);
+
+  return p;
+}
+
+bool AnalyticCollisionChecker::check(const Eigen::VectorXd& configuration)
+{
+  Eigen::Vector3d p = position(configuration);
+
+  // One configuration against all the obstacles
+  for(unsigned int j=0;j<(unsigned int) robot_spheres_.cols();j++)
+  {
+    Eigen::Vector3d c = p+robot_spheres_.col(j).head<3>();
+    double r = robot_spheres_(3,j);
+
+    if(sphere_r_.size()>0)
+    {
+      Eigen::ArrayXd d2 = (sphere_x_-c(0)).square()+(sphere_y_-c(1)).square()+(sphere_z_-c(2)).square();
+      if((d2<=(sphere_r_+r).square()).any())
+        return false;
+    }
+
+    if(box_x_.size()>0)
+    {
+      Eigen::ArrayXd dx = ((box_x_-c(0)).abs()-box_hx_).max(0.0);
+      Eigen::ArrayXd dy = ((box_y_-c(1)).abs()-box_hy_).max(0.0);
+      Eigen::ArrayXd dz = ((box_z_-c(2)).abs()-box_hz_).max(0.0);
+      if((dx.square()+dy.square()+dz.square()<=r*r).any())
+        return false;
+    }
+  }
+
+  return true;
+}
+
+bool AnalyticCollisionChecker::checkBatch(const Eigen::ArrayXd& x, const Eigen::ArrayXd& y, const Eigen::ArrayXd& z) const
+{
+  // All the configurations of the batch against one obstacle
+  for(unsigned int j=0;j<(unsigned int) robot_spheres_.cols();j++)
+  {
+    Eigen::ArrayXd cx = x+robot_spheres_(0,j);
+    Eigen::ArrayXd cy = y+robot_spheres_(1,j);
+    Eigen::ArrayXd cz = z+robot_spheres_(2,j);
+    double r = robot_spheres_(3,j);
+
+    for(unsigned int k=0;k<(unsigned int) sphere_r_.size();k++)
+    {
+      double rr = (sphere_r_(k)+r)*(sphere_r_(k)+r);
+      if(((cx-sphere_x_(k)).square()+(cy-sphere_y_(k)).square()+(cz-sphere_z_(k)).square()<=rr).any())
+        return false;
+    }
+
+    for(unsigned int k=0;k<(unsigned int) box_x_.size();k++)
+    {
+      Eigen::ArrayXd dx = ((cx-box_x_(k)).abs()-box_hx_(k)).max(0.0);
+      Eigen::ArrayXd dy = ((cy-box_y_(k)).abs()-box_hy_(k)).max(0.0);
+      Eigen::ArrayXd dz = ((cz-box_z_(k)).abs()-box_hz_(k)).max(0.0);
+      if((dx.square()+dy.square()+dz.square()<=r*r).any())
+        return false;
+    }
+  }
+
+  return true;
+}
+
+bool AnalyticCollisionChecker::checkPath(const Eigen::VectorXd& configuration1, const Eigen::VectorXd& configuration2)
+{
+  Eigen::Vector3d p1 = position(configuration1);
+  Eigen::Vector3d p2 = position(configuration2);
+
+  // Same resolution as the sampling-based checkers, measured in the configuration space
+  double distance = (configuration2-configuration1).norm();
+  unsigned int n_samples = std::ceil(distance/min_distance_)+1;
+
+  Eigen::ArrayXd t, x, y, z;
+  for(unsigned int first=0;first<n_samples;first+=batch_size_)
+  {
+    unsigned int n = std::min(batch_size_,n_samples-first);
+    if(n_samples>1)
+      t = Eigen::ArrayXd::LinSpaced(n,first,first+n-1)/(n_samples-1);
+    else
+      t = Eigen::ArrayXd::Zero(1);
+
+    x = p1(0)+t*(p2(0)-p1(0));
+    y = p1(1)+t*(p2(1)-p1(1));
+    z = p1(2)+t*(p2(2)-p1(2));
+
+    if(not checkBatch(x,y,z))
+      return false;
+  }
+
+  return true;
+}
+}
@@ -0,0 +1,109 @@
+#include "replanners_lib/batch_collision_checker.h"
+
+namespace pathplan
+{
+
+BatchCollisionChecker::BatchCollisionChecker(const std::vector<CollisionCheckerPtr>& checkers):
+  checkers_(checkers)
+{
+  if(checkers_.empty())
+    throw std::invalid_argument("at least one checker is needed");
+}
+
+BatchCollisionChecker::BatchCollisionChecker(const CollisionCheckerPtr& checker, const unsigned int& n_workers)
+{
+  for(unsigned int i=0;i<std::max(n_workers,1U);i++)
+    checkers_.push_back(checker->clone());
+}
+
+void BatchCollisionChecker::setPlanningSceneMsg(const moveit_msgs::PlanningScene& msg)
+{
+  for(const CollisionCheckerPtr& checker:checkers_)
+    checker->setPlanningSceneMsg(msg);
+}
+
+std::vector<bool> BatchCollisionChecker::check(const std::vector<Eigen::VectorXd>& configurations)
+{
+  std::vector<char> results(configurations.size()); //std::vector<bool> cannot be written concurrently
+  std::atomic<unsigned int> next(0);
+
+  auto worker = [&](const CollisionCheckerPtr& checker)
+  {
+    for(unsigned int i=next++;i<configurations.size();i=next++)
+      results[i] = checker->check(configurations[i]);
+  };
+
+  unsigned int n_workers = std::min(checkers_.size(),configurations.size());
+  std::vector<std::future<void>> tasks;
+  for(unsigned int w=1;w<n_workers;w++)
+    tasks.push_back(std::async(std::launch::async,worker,checkers_.at(w)));
+
+  if(n_workers>0)
+    worker(checkers_.front());
+
+  for(std::future<void>& task:tasks)
+    task.wait();
+
+  return std::vector<bool>(results.begin(),results.end());
+}
+
+std::vector<int> BatchCollisionChecker::checkPaths(const std::vector<std::pair<Eigen::VectorXd,Eigen::VectorXd>>& segments, const bool& stop_at_first_collision,
+                                                  const double& max_time)
+{
+  std::vector<int> status(segments.size(),UNCHECKED);
+  if(max_time<=0.0)
+    return status;
+
+  std::chrono::steady_clock::time_point tic = std::chrono::steady_clock::now();
+  bool timed = max_time<std::numeric_limits<double>::infinity();
+
+  std::atomic<unsigned int> next(0);
+  std::atomic<unsigned int> first_collision(segments.size());
+
+  auto worker = [&](const CollisionCheckerPtr& checker)
+  {
+    for(unsigned int i=next++;i<segments.size();i=next++)
+    {
+      if(stop_at_first_collision && i>first_collision)
+        break; //the next indices are larger
+
+      if(timed && std::chrono::duration<double>(std::chrono::steady_clock::now()-tic).count()>=max_time)
+        break;
+
+      if(checker->checkPath(segments[i].first,segments[i].second))
+        status[i] = FREE;
+      else
+      {
+        status[i] = OBSTRUCTED;
+
+        unsigned int first = first_collision;
+        while(i<first && not first_collision.compare_exchange_weak(first,i));
+      }
+    }
+  };
+
+  unsigned int n_workers = std::min(checkers_.size(),segments.size());
+  std::vector<std::future<void>> tasks;
+  for(unsigned int w=1;w<n_workers;w++)
+    tasks.push_back(std::async(std::launch::async,worker,checkers_.at(w)));
+
+  if(n_workers>0)
+    worker(checkers_.front());
+
+  for(std::future<void>& task:tasks)
+    task.wait();
+
+  return status;
+}
+
+std::vector<int> BatchCollisionChecker::checkConnections(const std::vector<ConnectionPtr>& connections, const bool& stop_at_first_collision,
+                                                        const double& max_time)
+{
+  std::vector<std::pair<Eigen::VectorXd,Eigen::VectorXd>> segments;
+  segments.reserve(connections.size());
+  for(const ConnectionPtr& conn:connections)
+    segments.push_back(std::make_pair(conn->getParent()->getConfiguration(),conn->getChild()->getConfiguration()));
+
+  return checkPaths(segments,stop_at_first_collision,max_time);
+}
+}
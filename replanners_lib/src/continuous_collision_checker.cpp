@@ -0,0 +1,173 @@
+#include "replanners_lib/continuous_collision_checker.h"
+
+namespace pathplan
+{
+
+ContinuousCollisionChecker::ContinuousCollisionChecker(const planning_scene::PlanningScenePtr& planning_scene,
+                                                       const std::string& group_name,
+                                                       const bool& check_self_collisions,
+                                                       const double& min_distance):
+  CollisionChecker(min_distance),
+  planning_scene_(planning_scene),
+  group_name_(group_name),
+  check_self_collisions_(check_self_collisions)
+{
+  state_ = std::make_shared<robot_state::RobotState>(planning_scene_->getCurrentState());
+  jmg_ = state_->getJointModelGroup(group_name_);
+  if(not jmg_)
+    throw std::invalid_argument("group "+group_name_+" does not exist");
+
+  computeLeverArms();
+}
+
+void ContinuousCollisionChecker::computeLeverArms()
+{
+  // Any point of a link is within the sphere circumscribing the bounding box of its collision geometry
+  std::map<const robot_model::LinkModel*,double> reach;
+  for(const robot_model::LinkModel* link:jmg_->getUpdatedLinkModelsWithGeometry())
+    reach[link] = link->getCenteredBoundingBoxOffset().norm()+0.5*link->getShapeExtentsAtOrigin().norm();
+
+  // Any point of an attached shape is within its bounding sphere, placed in the frame of the link it is attached to
+  std::vector<const robot_state::AttachedBody*> bodies;
+  state_->getAttachedBodies(bodies);
+  for(const robot_state::AttachedBody* body:bodies)
+  {
+    const robot_model::LinkModel* link = body->getAttachedLink();
+    if(not jmg_->isLinkUpdated(link->getName()))
+      continue; //it does not move with the group
+
+    for(unsigned int i=0;i<body->getShapes().size() && i<body->getFixedTransforms().size();i++)
+    {
+      Eigen::Vector3d center;
+      double radius;
+      shapes::computeShapeBoundingSphere(body->getShapes().at(i).get(),center,radius);
+
+      reach[link] = std::max(reach[link],(body->getFixedTransforms().at(i)*center).norm()+radius);
+    }
+  }
+
+  lever_arms_.setZero(reach.size(),jmg_->getActiveJointModels().size());
+  unsigned int i = 0;
+  for(const std::pair<const robot_model::LinkModel* const,double>& link_reach:reach)
+    lever_arms_.row(i++) = SdfCollisionChecker::leverArms(jmg_,link_reach.first,link_reach.second);
+}
+
+double ContinuousCollisionChecker::distance(const Eigen::VectorXd& configuration)
+{
+  state_->setJointGroupPositions(jmg_,configuration);
+  state_->update();
+
+  return planning_scene_->distanceToCollision(*state_);
+}
+
+bool ContinuousCollisionChecker::checkSelfCollision(const Eigen::VectorXd& configuration)
+{
+  state_->setJointGroupPositions(jmg_,configuration);
+  state_->update();
+
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  req.group_name = group_name_;
+
+  planning_scene_->checkSelfCollision(req,res,*state_);
+
+  return not res.collision;
+}
+
+void ContinuousCollisionChecker::setPlanningSceneMsg(const moveit_msgs::PlanningScene& msg)
+{
+  if(not planning_scene_->setPlanningSceneMsg(msg))
+    ROS_ERROR("unable to update planning scene");
+
+  if(not msg.is_diff || not msg.robot_state.attached_collision_objects.empty())
+  {
+    *state_ = planning_scene_->getCurrentState();
+    computeLeverArms();
+  }
+}
+
+bool ContinuousCollisionChecker::check(const Eigen::VectorXd& configuration)
+{
+  if(distance(configuration)<=0.0)
+    return false;
+
+  if(check_self_collisions_ && not checkSelfCollision(configuration))
+    return false;
+
+  return true;
+}
+
+bool ContinuousCollisionChecker::firstContact(const Eigen::VectorXd& configuration1, const Eigen::VectorXd& configuration2, Eigen::VectorXd& contact)
+{
+  double length = (configuration2-configuration1).norm();
+  if(length<min_distance_)
+  {
+    if(not check(configuration1))
+    {
+      contact = configuration1;
+      return true;
+    }
+    if(not check(configuration2))
+    {
+      contact = configuration2;
+      return true;
+    }
+    return false;
+  }
+
+  Eigen::VectorXd direction = (configuration2-configuration1)/length;
+  double velocity = (lever_arms_.rows()>0)? (lever_arms_*direction.cwiseAbs()).maxCoeff(): 0.0; //bound of the motion of the robot per unit of length
+
+  // Conservative advancement against the world
+  double s = 0.0;
+  double s_contact = std::numeric_limits<double>::infinity();
+  while(true)
+  {
+    double d = distance(configuration1+s*direction);
+    if(d<=0.0)
+    {
+      s_contact = s;
+      break;
+    }
+
+    if(s>=length)
+      break;
+
+    double step = (velocity>0.0)? d/velocity: length;
+    s = std::min(s+std::max(step,min_distance_),length);
+  }
+
+  if(check_self_collisions_)
+  {
+    double s_max = std::min(s_contact,length);
+    unsigned int n_steps = std::ceil(s_max/min_distance_);
+    for(unsigned int i=0;i<=n_steps;i++)
+    {
+      double s_self = (n_steps>0)? s_max*i/n_steps: 0.0;
+      if(not checkSelfCollision(configuration1+s_self*direction))
+      {
+        s_contact = s_self;
+        break;
+      }
+    }
+  }
+
+  if(s_contact == std::numeric_limits<double>::infinity())
+    return false;
+
+  contact = configuration1+s_contact*direction;
+  return true;
+}
+
+bool ContinuousCollisionChecker::checkPath(const Eigen::VectorXd& configuration1, const Eigen::VectorXd& configuration2)
+{
+  Eigen::VectorXd contact;
+  return not firstContact(configuration1,configuration2,contact);
+}
+
+CollisionCheckerPtr ContinuousCollisionChecker::clone()
+{
+  return std::make_shared<ContinuousCollisionChecker>(planning_scene::PlanningScene::clone(planning_scene_),group_name_,
+                                                      check_self_collisions_,min_distance_);
+}
+}
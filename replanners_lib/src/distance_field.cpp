@@ -0,0 +1,314 @@
+#include "replanners_lib/distance_field.h"
+
+namespace pathplan
+{
+
+static Eigen::Isometry3d fromPoseMsg(const geometry_msgs::Pose& pose)
+{
+  Eigen::Quaterniond q(pose.orientation.w,pose.orientation.x,pose.orientation.y,pose.orientation.z);
+  if(q.norm()<1e-6)
+    q = Eigen::Quaterniond::Identity();
+
+  Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+  T.linear() = q.normalized().toRotationMatrix();
+  T.translation()<<pose.position.x,pose.position.y,pose.position.z;
+
+  return T;
+}
+
+DistanceField::DistanceField(const Eigen::Vector3d& lb,
+                             const Eigen::Vector3d& ub,
+                             const double& resolution,
+                             const double& truncation):
+  origin_(lb),
+  resolution_(resolution),
+  truncation_(truncation)
+{
+  if(resolution_<=0.0 || (ub-lb).minCoeff()<=0.0)
+    throw std::invalid_argument("invalid distance field bounds or resolution");
+
+  size_ = (((ub-lb)/resolution_).array().ceil()+1).cast<int>();
+  voxel_radius_ = 0.5*std::sqrt(3.0)*resolution_;
+  distance_.assign((size_t) size_.prod(),truncation_);
+}
+
+double DistanceField::shapeDistance(const Shape& shape, const Eigen::Vector3d& point)
+{
+  Eigen::Vector3d p = shape.inverse_pose*point;
+
+  switch(shape.type)
+  {
+  case shape_msgs::SolidPrimitive::SPHERE:
+    return p.norm()-shape.dimensions(0);
+  case shape_msgs::SolidPrimitive::BOX:
+  {
+    Eigen::Vector3d q = p.cwiseAbs()-shape.dimensions;
+    return q.cwiseMax(0.0).norm()+std::min(q.maxCoeff(),0.0);
+  }
+  default: //cylinder
+  {
+    Eigen::Vector2d q(p.head<2>().norm()-shape.dimensions(0),std::abs(p(2))-shape.dimensions(2));
+    return q.cwiseMax(0.0).norm()+std::min(q.maxCoeff(),0.0);
+  }
+  }
+}
+
+DistanceField::Object DistanceField::fromMsg(const moveit_msgs::CollisionObject& msg, const planning_scene::PlanningSceneConstPtr& scene) const
+{
+  Object object;
+  object.msg = msg;
+  object.region.setEmpty();
+
+  Eigen::Isometry3d object_pose = fromPoseMsg(msg.pose);
+  if(scene && not msg.header.frame_id.empty())
+    object_pose = scene->getFrameTransform(msg.header.frame_id)*object_pose;
+
+  Eigen::Isometry3d pose;
+  Eigen::Vector3d half_extents;
+  for(unsigned int i=0;i<msg.primitives.size() && i<msg.primitive_poses.size();i++)
+  {
+    const shape_msgs::SolidPrimitive& primitive = msg.primitives.at(i);
+    pose = object_pose*fromPoseMsg(msg.primitive_poses.at(i));
+
+    Shape shape;
+    shape.type = primitive.type;
+    switch(primitive.type)
+    {
+    case shape_msgs::SolidPrimitive::SPHERE:
+      shape.dimensions.setConstant(primitive.dimensions.at(shape_msgs::SolidPrimitive::SPHERE_RADIUS));
+      break;
+    case shape_msgs::SolidPrimitive::BOX:
+      shape.dimensions<<primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_X),
+          primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_Y),
+          primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_Z);
+      shape.dimensions = 0.5*shape.dimensions;
+      break;
+    case shape_msgs::SolidPrimitive::CYLINDER:
+    case shape_msgs::SolidPrimitive::CONE:
+    {
+      // CYLINDER_HEIGHT == CONE_HEIGHT and CYLINDER_RADIUS == CONE_RADIUS
+      double r = primitive.dimensions.at(shape_msgs::SolidPrimitive::CYLINDER_RADIUS);
+      shape.type = shape_msgs::SolidPrimitive::CYLINDER;
+      shape.dimensions<<r,r,0.5*primitive.dimensions.at(shape_msgs::SolidPrimitive::CYLINDER_HEIGHT);
+      break;
+    }
+    default:
+      ROS_WARN_STREAM("primitive type "<<(int) primitive.type<<" of object "<<msg.id<<" not supported");
+      continue;
+    }
+
+    shape.inverse_pose = pose.inverse();
+    object.shapes.push_back(shape);
+
+    half_extents = (shape.type == shape_msgs::SolidPrimitive::SPHERE)? shape.dimensions: Eigen::Vector3d(pose.linear().cwiseAbs()*shape.dimensions);
+    object.region.extend(pose.translation()-half_extents);
+    object.region.extend(pose.translation()+half_extents);
+  }
+
+  for(unsigned int i=0;i<msg.meshes.size() && i<msg.mesh_poses.size();i++)
+  {
+    const shape_msgs::Mesh& mesh = msg.meshes.at(i);
+    if(mesh.vertices.empty())
+      continue;
+
+    Eigen::AlignedBox3d bounds;
+    for(const geometry_msgs::Point& v:mesh.vertices)
+      bounds.extend(Eigen::Vector3d(v.x,v.y,v.z));
+
+    pose = object_pose*fromPoseMsg(msg.mesh_poses.at(i));
+    pose.translate(bounds.center());
+
+    Shape shape;
+    shape.type = shape_msgs::SolidPrimitive::BOX;
+    shape.dimensions = 0.5*bounds.sizes();
+    shape.inverse_pose = pose.inverse();
+    object.shapes.push_back(shape);
+
+    half_extents = pose.linear().cwiseAbs()*shape.dimensions;
+    object.region.extend(pose.translation()-half_extents);
+    object.region.extend(pose.translation()+half_extents);
+  }
+
+  if(not msg.planes.empty())
+    ROS_WARN_STREAM("planes of object "<<msg.id<<" are ignored");
+
+  if(not object.region.isEmpty())
+  {
+    object.region.min().array() -= truncation_;
+    object.region.max().array() += truncation_;
+  }
+
+  return object;
+}
+
+void DistanceField::updateRegion(const Eigen::AlignedBox3d& region)
+{
+  if(region.isEmpty())
+    return;
+
+  Eigen::Vector3i first = ((region.min()-origin_)/resolution_).array().floor().cast<int>().max(0);
+  Eigen::Vector3i last  = ((region.max()-origin_)/resolution_).array().ceil ().cast<int>().min(size_.array()-1);
+  if((last.array()<first.array()).any())
+    return;
+
+  // Only the objects overlapping the region can set its voxels
+  std::vector<const Shape*> shapes;
+  for(const std::pair<const std::string,Object>& object:objects_)
+  {
+    if(object.second.region.intersects(region))
+    {
+      for(const Shape& shape:object.second.shapes)
+        shapes.push_back(&shape);
+    }
+  }
+
+  Eigen::Vector3d point;
+  for(int ix=first(0);ix<=last(0);ix++)
+  {
+    for(int iy=first(1);iy<=last(1);iy++)
+    {
+      for(int iz=first(2);iz<=last(2);iz++)
+      {
+        point = origin_+resolution_*Eigen::Vector3d(ix,iy,iz);
+
+        double d = truncation_;
+        for(const Shape* shape:shapes)
+          d = std::min(d,shapeDistance(*shape,point));
+
+        distance_[((size_t) ix*size_(1)+iy)*size_(2)+iz] = d;
+      }
+    }
+  }
+}
+
+bool DistanceField::sameGeometry(const moveit_msgs::CollisionObject& obj1, const moveit_msgs::CollisionObject& obj2) const
+{
+  return (obj1.header.frame_id == obj2.header.frame_id && obj1.pose == obj2.pose &&
+          obj1.primitives == obj2.primitives && obj1.primitive_poses == obj2.primitive_poses &&
+          obj1.meshes     == obj2.meshes     && obj1.mesh_poses      == obj2.mesh_poses);
+}
+
+void DistanceField::addObject(const moveit_msgs::CollisionObject& object, const planning_scene::PlanningSceneConstPtr& scene)
+{
+  Eigen::AlignedBox3d old_region;
+  old_region.setEmpty();
+
+  std::map<std::string,Object>::iterator it = objects_.find(object.id);
+  if(it != objects_.end())
+  {
+    if(sameGeometry(it->second.msg,object))
+      return;
+
+    old_region = it->second.region;
+  }
+
+  objects_[object.id] = fromMsg(object,scene);
+
+  updateRegion(old_region);
+  updateRegion(objects_[object.id].region);
+}
+
+void DistanceField::removeObject(const std::string& id)
+{
+  std::map<std::string,Object>::iterator it = objects_.find(id);
+  if(it == objects_.end())
+    return;
+
+  Eigen::AlignedBox3d region = it->second.region;
+  objects_.erase(it);
+
+  updateRegion(region);
+}
+
+void DistanceField::clearObjects()
+{
+  objects_.clear();
+  std::fill(distance_.begin(),distance_.end(),truncation_);
+}
+
+bool DistanceField::needsUpdate(const moveit_msgs::PlanningSceneWorld& world, const bool& is_diff) const
+{
+  if(not is_diff)
+  {
+    if(world.collision_objects.size() != objects_.size())
+      return true;
+  }
+
+  for(const moveit_msgs::CollisionObject& object:world.collision_objects)
+  {
+    std::map<std::string,Object>::const_iterator it = objects_.find(object.id);
+    if(object.operation == moveit_msgs::CollisionObject::REMOVE)
+    {
+      if(it != objects_.end() || object.id.empty())
+        return true;
+    }
+    else if(object.operation == moveit_msgs::CollisionObject::MOVE)
+    {
+      if(it != objects_.end() && (it->second.msg.pose != object.pose || it->second.msg.header.frame_id != object.header.frame_id))
+        return true;
+    }
+    else if(it == objects_.end() || not sameGeometry(it->second.msg,object))
+      return true;
+  }
+
+  return false;
+}
+
+void DistanceField::setWorldMsg(const moveit_msgs::PlanningSceneWorld& world, const bool& is_diff, const planning_scene::PlanningSceneConstPtr& scene)
+{
+  if(not is_diff)
+  {
+    std::vector<std::string> removed;
+    for(const std::pair<const std::string,Object>& object:objects_)
+    {
+      if(std::find_if(world.collision_objects.begin(),world.collision_objects.end(),
+                      [&](const moveit_msgs::CollisionObject& o){return o.id == object.first;}) == world.collision_objects.end())
+        removed.push_back(object.first);
+    }
+
+    for(const std::string& id:removed)
+      removeObject(id);
+  }
+
+  for(const moveit_msgs::CollisionObject& object:world.collision_objects)
+  {
+    switch(object.operation)
+    {
+    case moveit_msgs::CollisionObject::ADD:
+      addObject(object,scene);
+      break;
+    case moveit_msgs::CollisionObject::MOVE:
+    {
+      // As in MoveIt, only the pose of an existing object changes
+      std::map<std::string,Object>::const_iterator it = objects_.find(object.id);
+      if(it == objects_.end())
+        break;
+
+      moveit_msgs::CollisionObject moved = it->second.msg;
+      moved.header = object.header;
+      moved.pose = object.pose;
+      addObject(moved,scene);
+      break;
+    }
+    case moveit_msgs::CollisionObject::REMOVE:
+      if(object.id.empty())
+        clearObjects();
+      else
+        removeObject(object.id);
+      break;
+    default:
+      ROS_WARN_STREAM("operation "<<(int) object.operation<<" on object "<<object.id<<" not supported");
+    }
+  }
+}
+
+double DistanceField::distance(const Eigen::Vector3d& point) const
+{
+  Eigen::Vector3i idx = ((point-origin_)/resolution_).array().round().cast<int>();
+  if((idx.array()<0).any() || (idx.array()>=size_.array()).any())
+    return truncation_;
+
+  // The field is 1-Lipschitz: the value at the closest voxel minus its half diagonal is a lower bound
+  return distance_[((size_t) idx(0)*size_(1)+idx(1))*size_(2)+idx(2)]-voxel_radius_;
+}
+}
@@ -0,0 +1,264 @@
+#include "replanners_lib/obstacle_predictor.h"
+
+namespace pathplan
+{
+
+ObstaclePredictor::ObstaclePredictor(const double& horizon, const double& step, const unsigned int& max_copies):
+  horizon_(horizon),
+  step_(step),
+  max_copies_(std::max(max_copies,(unsigned int) 2))
+{
+  if(horizon_<=0.0 || step_<=0.0)
+    throw std::invalid_argument("horizon and step must be positive");
+}
+
+Eigen::Isometry3d ObstaclePredictor::fromPoseMsg(const geometry_msgs::Pose& pose)
+{
+  Eigen::Quaterniond q(pose.orientation.w,pose.orientation.x,pose.orientation.y,pose.orientation.z);
+  if(q.norm()<1e-6)
+    q = Eigen::Quaterniond::Identity();
+
+  Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+  T.linear() = q.normalized().toRotationMatrix();
+  T.translation()<<pose.position.x,pose.position.y,pose.position.z;
+
+  return T;
+}
+
+bool ObstaclePredictor::objectPosition(const moveit_msgs::CollisionObject& object, Eigen::Vector3d& position)
+{
+  const geometry_msgs::Pose* pose;
+  if(not object.primitive_poses.empty())
+    pose = &object.primitive_poses.front();
+  else if(not object.mesh_poses.empty())
+    pose = &object.mesh_poses.front();
+  else
+    return false;
+
+  position = fromPoseMsg(object.pose)*Eigen::Vector3d(pose->position.x,pose->position.y,pose->position.z);
+  return true;
+}
+
+bool ObstaclePredictor::localBox(const moveit_msgs::CollisionObject& object, Eigen::Vector3d& lb, Eigen::Vector3d& ub)
+{
+  lb.setConstant( std::numeric_limits<double>::infinity());
+  ub.setConstant(-std::numeric_limits<double>::infinity());
+
+  Eigen::Vector3d half_extents;
+  for(unsigned int i=0;i<object.primitives.size() && i<object.primitive_poses.size();i++)
+  {
+    const shape_msgs::SolidPrimitive& primitive = object.primitives.at(i);
+    switch(primitive.type)
+    {
+    case shape_msgs::SolidPrimitive::SPHERE:
+      half_extents.setConstant(primitive.dimensions.at(shape_msgs::SolidPrimitive::SPHERE_RADIUS));
+      break;
+    case shape_msgs::SolidPrimitive::BOX:
+      half_extents<<primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_X),
+          primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_Y),
+          primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_Z);
+      half_extents = 0.5*half_extents;
+      break;
+    case shape_msgs::SolidPrimitive::CYLINDER:
+    case shape_msgs::SolidPrimitive::CONE:
+    {
+      // CYLINDER_HEIGHT == CONE_HEIGHT and CYLINDER_RADIUS == CONE_RADIUS
+      double r = primitive.dimensions.at(shape_msgs::SolidPrimitive::CYLINDER_RADIUS);
+      half_extents<<r,r,0.5*primitive.dimensions.at(shape_msgs::SolidPrimitive::CYLINDER_HEIGHT);
+      break;
+    }
+    default:
+      return false;
+    }
+
+    Eigen::Isometry3d pose = fromPoseMsg(object.primitive_poses.at(i));
+    Eigen::Vector3d extents = pose.linear().cwiseAbs()*half_extents;
+    lb = lb.cwiseMin(pose.translation()-extents);
+    ub = ub.cwiseMax(pose.translation()+extents);
+  }
+
+  for(unsigned int i=0;i<object.meshes.size() && i<object.mesh_poses.size();i++)
+  {
+    Eigen::Isometry3d pose = fromPoseMsg(object.mesh_poses.at(i));
+    for(const geometry_msgs::Point& v:object.meshes.at(i).vertices)
+    {
+      Eigen::Vector3d p = pose*Eigen::Vector3d(v.x,v.y,v.z);
+      lb = lb.cwiseMin(p);
+      ub = ub.cwiseMax(p);
+    }
+  }
+
+  return (lb.array()<=ub.array()).all();
+}
+
+double ObstaclePredictor::minExtent(const moveit_msgs::CollisionObject& object)
+{
+  double extent = std::numeric_limits<double>::infinity();
+  for(const shape_msgs::SolidPrimitive& primitive:object.primitives)
+  {
+    switch(primitive.type)
+    {
+    case shape_msgs::SolidPrimitive::SPHERE:
+      extent = std::min(extent,2.0*primitive.dimensions.at(shape_msgs::SolidPrimitive::SPHERE_RADIUS));
+      break;
+    case shape_msgs::SolidPrimitive::BOX:
+      extent = std::min({extent,primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_X),
+                         primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_Y),
+                         primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_Z)});
+      break;
+    case shape_msgs::SolidPrimitive::CYLINDER:
+    case shape_msgs::SolidPrimitive::CONE:
+      extent = std::min({extent,2.0*primitive.dimensions.at(shape_msgs::SolidPrimitive::CYLINDER_RADIUS),
+                         primitive.dimensions.at(shape_msgs::SolidPrimitive::CYLINDER_HEIGHT)});
+      break;
+    }
+  }
+
+  for(const shape_msgs::Mesh& mesh:object.meshes)
+  {
+    Eigen::Vector3d lb = Eigen::Vector3d::Constant( std::numeric_limits<double>::infinity());
+    Eigen::Vector3d ub = Eigen::Vector3d::Constant(-std::numeric_limits<double>::infinity());
+    for(const geometry_msgs::Point& v:mesh.vertices)
+    {
+      lb = lb.cwiseMin(Eigen::Vector3d(v.x,v.y,v.z));
+      ub = ub.cwiseMax(Eigen::Vector3d(v.x,v.y,v.z));
+    }
+
+    if(not mesh.vertices.empty())
+      extent = std::min(extent,(ub-lb).minCoeff());
+  }
+
+  return extent;
+}
+
+void ObstaclePredictor::update(const moveit_msgs::PlanningSceneWorld& world, const double& time)
+{
+  std::map<std::string,Track> tracks;
+
+  Eigen::Vector3d position;
+  for(const moveit_msgs::CollisionObject& obj:world.collision_objects)
+  {
+    if(not objectPosition(obj,position))
+      continue;
+
+    std::map<std::string,Track>::const_iterator it = tracks_.find(obj.id);
+    if(it == tracks_.end() || it->second.frame != obj.header.frame_id)
+    {
+      tracks[obj.id] = Track{position,Eigen::Vector3d::Zero(),time,obj.header.frame_id};
+      continue;
+    }
+
+    Track track = it->second;
+    double dt = time-track.time;
+    if((position-track.position).norm()>1.0e-6 && dt>0.0)
+    {
+      // Moved since the last displacement
+      track.velocity = (dt<=horizon_)? Eigen::Vector3d((position-track.position)/dt): Eigen::Vector3d::Zero();
+      track.position = position;
+      track.time = time;
+    }
+    else if(dt>horizon_) //still for too long
+      track.velocity.setZero();
+
+    tracks[obj.id] = track;
+  }
+
+  tracks_ = tracks;
+}
+
+Eigen::Vector3d ObstaclePredictor::velocity(const std::string& id) const
+{
+  std::map<std::string,Track>::const_iterator it = tracks_.find(id);
+  return (it != tracks_.end())? it->second.velocity: Eigen::Vector3d::Zero();
+}
+
+moveit_msgs::PlanningSceneWorld ObstaclePredictor::predict(const moveit_msgs::PlanningSceneWorld& world, const double& t0, const double& t1) const
+{
+  moveit_msgs::PlanningSceneWorld predicted_world = world;
+
+  for(moveit_msgs::CollisionObject& obj:predicted_world.collision_objects)
+  {
+    Eigen::Vector3d v = velocity(obj.id);
+    double speed = v.norm();
+    if(speed<1.0e-6)
+      continue;
+
+    // The velocity is in the header frame, the shapes are placed in the object frame
+    Eigen::Vector3d v_local = fromPoseMsg(obj.pose).linear().transpose()*v;
+
+    // Copies spaced by half the smallest extent of the object so that consecutive copies overlap
+    double extent = minExtent(obj);
+    double copies = (extent<std::numeric_limits<double>::infinity() && extent>0.0)?
+          std::ceil(2.0*speed*(t1-t0)/extent)+1.0: 2.0;
+
+    Eigen::Vector3d lb, ub;
+    if(copies>max_copies_ && localBox(obj,lb,ub))
+    {
+      // A single box bounding the object at t0 and t1 contains the whole sweep
+      Eigen::Vector3d d0 = v_local*t0;
+      Eigen::Vector3d d1 = v_local*t1;
+      Eigen::Vector3d box_lb = (lb+d0).cwiseMin(lb+d1);
+      Eigen::Vector3d box_ub = (ub+d0).cwiseMax(ub+d1);
+
+      shape_msgs::SolidPrimitive box;
+      box.type = shape_msgs::SolidPrimitive::BOX;
+      box.dimensions.resize(3);
+      box.dimensions.at(shape_msgs::SolidPrimitive::BOX_X) = box_ub(0)-box_lb(0);
+      box.dimensions.at(shape_msgs::SolidPrimitive::BOX_Y) = box_ub(1)-box_lb(1);
+      box.dimensions.at(shape_msgs::SolidPrimitive::BOX_Z) = box_ub(2)-box_lb(2);
+
+      geometry_msgs::Pose box_pose;
+      box_pose.position.x = 0.5*(box_lb(0)+box_ub(0));
+      box_pose.position.y = 0.5*(box_lb(1)+box_ub(1));
+      box_pose.position.z = 0.5*(box_lb(2)+box_ub(2));
+      box_pose.orientation.w = 1.0;
+
+      obj.primitives      = {box};
+      obj.primitive_poses = {box_pose};
+      obj.meshes     .clear();
+      obj.mesh_poses .clear();
+      obj.operation       = moveit_msgs::CollisionObject::ADD;
+      continue;
+    }
+
+    unsigned int n_copies = std::min(copies,(double) max_copies_);
+
+    std::vector<shape_msgs::SolidPrimitive> primitives;
+    std::vector<geometry_msgs::Pose> primitive_poses;
+    std::vector<shape_msgs::Mesh> meshes;
+    std::vector<geometry_msgs::Pose> mesh_poses;
+    for(unsigned int i=0;i<n_copies;i++)
+    {
+      double t = (n_copies>1)? t0+(t1-t0)*i/(n_copies-1): t0;
+      for(unsigned int j=0;j<obj.primitives.size() && j<obj.primitive_poses.size();j++)
+      {
+        geometry_msgs::Pose pose = obj.primitive_poses.at(j);
+        pose.position.x += v_local(0)*t;
+        pose.position.y += v_local(1)*t;
+        pose.position.z += v_local(2)*t;
+
+        primitives.push_back(obj.primitives.at(j));
+        primitive_poses.push_back(pose);
+      }
+      for(unsigned int j=0;j<obj.meshes.size() && j<obj.mesh_poses.size();j++)
+      {
+        geometry_msgs::Pose pose = obj.mesh_poses.at(j);
+        pose.position.x += v_local(0)*t;
+        pose.position.y += v_local(1)*t;
+        pose.position.z += v_local(2)*t;
+
+        meshes.push_back(obj.meshes.at(j));
+        mesh_poses.push_back(pose);
+      }
+    }
+
+    obj.primitives      = primitives     ;
+    obj.primitive_poses = primitive_poses;
+    obj.meshes          = meshes         ;
+    obj.mesh_poses      = mesh_poses     ;
+    obj.operation       = moveit_msgs::CollisionObject::ADD;
+  }
+
+  return predicted_world;
+}
+}
@@ -0,0 +1,451 @@
+#include "replanners_lib/online_trajectory_generator.h"
+
+namespace pathplan
+{
+
+OnlineTrajectoryGenerator::OnlineTrajectoryGenerator(const Eigen::VectorXd& max_velocity,
+                                                     const Eigen::VectorXd& max_acceleration,
+                                                     const Eigen::VectorXd& max_jerk,
+                                                     const double& blend_step,
+                                                     const double& max_deviation):
+  max_velocity_(max_velocity),
+  max_acceleration_(max_acceleration),
+  max_jerk_(max_jerk),
+  blend_step_(blend_step),
+  max_deviation_(max_deviation)
+{
+  if(max_velocity_.size() != max_acceleration_.size() || max_velocity_.size() != max_jerk_.size())
+    throw std::invalid_argument("limits of different sizes");
+
+  if((max_velocity_.array()<=0.0).any() || (max_acceleration_.array()<=0.0).any() || (max_jerk_.array()<=0.0).any())
+    throw std::invalid_argument("limits must be positive");
+
+  if(blend_step_<=0.0)
+    throw std::invalid_argument("blend step must be positive");
+
+  if(max_deviation_<0.0)
+    throw std::invalid_argument("max deviation must be non-negative");
+}
+
+OnlineTrajectoryGenerator::Setpoint OnlineTrajectoryGenerator::Quintic::evaluate(const double& t) const
+{
+  Setpoint setpoint;
+  setpoint.time         = t;
+  setpoint.position     = c0+t*(c1+t*(c2+t*(c3+t*(c4+t*c5))));
+  setpoint.velocity     = c1+t*(2.0*c2+t*(3.0*c3+t*(4.0*c4+t*5.0*c5)));
+  setpoint.acceleration = 2.0*c2+t*(6.0*c3+t*(12.0*c4+t*20.0*c5));
+
+  return setpoint;
+}
+
+OnlineTrajectoryGenerator::Setpoint OnlineTrajectoryGenerator::Segment::at(const double& s) const
+{
+  double a  = max_acc;
+  double v0 = start_speed;
+  double v1 = end_speed;
+
+  double peak = std::min(max_speed,std::sqrt(a*length+0.5*(v0*v0+v1*v1)));
+  double accelerating = std::max((peak*peak-v0*v0)/(2.0*a),0.0);
+  double decelerating = std::max((peak*peak-v1*v1)/(2.0*a),0.0);
+  double cruise = std::max(length-accelerating-decelerating,0.0);
+
+  double v, t, acc;
+  if(s<=accelerating)
+  {
+    v = std::sqrt(v0*v0+2.0*a*s);
+    t = (v-v0)/a;
+    acc = a;
+  }
+  else if(s<=accelerating+cruise)
+  {
+    v = peak;
+    t = (peak-v0)/a+(s-accelerating)/peak;
+    acc = 0.0;
+  }
+  else
+  {
+    v = std::sqrt(std::max(peak*peak-2.0*a*(s-accelerating-cruise),0.0));
+    t = (peak-v0)/a+cruise/peak+(peak-v)/a;
+    acc = -a;
+  }
+
+  return Setpoint{t,start+s*dir,v*dir,acc*dir};
+}
+
+OnlineTrajectoryGenerator::Quintic OnlineTrajectoryGenerator::quintic(const Setpoint& start, const Setpoint& end)
+{
+  double T = end.time-start.time;
+  Eigen::VectorXd h = end.position-start.position;
+
+  const Eigen::VectorXd& v0 = start.velocity;
+  const Eigen::VectorXd& v1 = end.velocity;
+  const Eigen::VectorXd& a0 = start.acceleration;
+  const Eigen::VectorXd& a1 = end.acceleration;
+
+  Quintic blend;
+  blend.duration = T;
+  blend.c0 = start.position;
+  blend.c1 = v0;
+  blend.c2 = 0.5*a0;
+  blend.c3 = ( 20.0*h-( 8.0*v1+12.0*v0)*T-(3.0*a0-    a1)*T*T)/(2.0*std::pow(T,3));
+  blend.c4 = (-30.0*h+(14.0*v1+16.0*v0)*T+(3.0*a0-2.0*a1)*T*T)/(2.0*std::pow(T,4));
+  blend.c5 = ( 12.0*h-  6.0*(v1+v0)*T    +(    a1-    a0)*T*T)/(2.0*std::pow(T,5));
+
+  return blend;
+}
+
+static double polyval(const std::vector<double>& c, const double& t)
+{
+  double p = 0.0;
+  for(int k=c.size()-1;k>=0;k--)
+    p = p*t+c[k];
+
+  return p;
+}
+
+std::vector<double> OnlineTrajectoryGenerator::roots(const std::vector<double>& c, const double& lo, const double& hi)
+{
+  std::vector<double> p = c;
+  while(not p.empty() && p.back() == 0.0)
+    p.pop_back();
+
+  std::vector<double> r;
+  if(p.size()<2)
+    return r;
+
+  if(p.size() == 2)
+  {
+    double t = -p[0]/p[1];
+    if(t>=lo && t<=hi)
+      r.push_back(t);
+
+    return r;
+  }
+
+  std::vector<double> dp(p.size()-1);
+  for(unsigned int k=0;k<dp.size();k++)
+    dp[k] = (k+1)*p[k+1];
+
+  // p is monotone between two consecutive roots of its derivative, so it has at most one root there
+  std::vector<double> bounds = roots(dp,lo,hi);
+  bounds.insert(bounds.begin(),lo);
+  bounds.push_back(hi);
+
+  for(unsigned int i=0;i<bounds.size()-1;i++)
+  {
+    double a = bounds[i];
+    double b = bounds[i+1];
+    double fa = polyval(p,a);
+    double fb = polyval(p,b);
+
+    if(fa == 0.0)
+      r.push_back(a);
+    else if(fa*fb<0.0)
+    {
+      for(unsigned int iter=0;iter<100 && (b-a)>1.0e-12;iter++)
+      {
+        double m = 0.5*(a+b);
+        double fm = polyval(p,m);
+        if(fa*fm<=0.0)
+          b = m;
+        else
+        {
+          a = m;
+          fa = fm;
+        }
+      }
+      r.push_back(0.5*(a+b));
+    }
+  }
+
+  if(polyval(p,hi) == 0.0)
+    r.push_back(hi);
+
+  return r;
+}
+
+double OnlineTrajectoryGenerator::maxAbs(const std::vector<double>& c, const double& duration)
+{
+  std::vector<double> dc(c.size()-1);
+  for(unsigned int k=0;k<dc.size();k++)
+    dc[k] = (k+1)*c[k+1];
+
+  std::vector<double> t = roots(dc,0.0,duration);
+  t.push_back(0.0);
+  t.push_back(duration);
+
+  double max_abs = 0.0;
+  for(const double& ti:t)
+    max_abs = std::max(max_abs,std::abs(polyval(c,ti)));
+
+  return max_abs;
+}
+
+bool OnlineTrajectoryGenerator::withinLimits(const Quintic& blend) const
+{
+  // The blend starts from the current state, which may already be slightly beyond the limits
+  Eigen::VectorXd max_velocity     = max_velocity_    .cwiseMax(blend.c1.cwiseAbs()    );
+  Eigen::VectorXd max_acceleration = max_acceleration_.cwiseMax(2.0*blend.c2.cwiseAbs());
+
+  // Velocity, acceleration and jerk of each joint are polynomials of degree 4, 3 and 2: their extrema are at the ends or where their derivative vanishes
+  for(unsigned int j=0;j<blend.c0.size();j++)
+  {
+    double c1 = blend.c1(j), c2 = blend.c2(j), c3 = blend.c3(j), c4 = blend.c4(j), c5 = blend.c5(j);
+
+    if(maxAbs({6.0*c3,24.0*c4,60.0*c5},blend.duration)>max_jerk_(j)+1.0e-6)
+      return false;
+    if(maxAbs({2.0*c2,6.0*c3,12.0*c4,20.0*c5},blend.duration)>max_acceleration(j)+1.0e-6)
+      return false;
+    if(maxAbs({c1,2.0*c2,3.0*c3,4.0*c4,5.0*c5},blend.duration)>max_velocity(j)+1.0e-6)
+      return false;
+  }
+
+  return true;
+}
+
+double OnlineTrajectoryGenerator::distance(const Eigen::VectorXd& q, const Eigen::VectorXd& a, const Eigen::VectorXd& b)
+{
+  double length = (b-a).norm();
+  if(length<1.0e-12)
+    return (q-a).norm();
+
+  double s = std::min(std::max((q-a).dot(b-a)/length,0.0),length);
+  return ((q-a)-s*(b-a)/length).norm();
+}
+
+bool OnlineTrajectoryGenerator::withinTube(const Quintic& blend, const Eigen::VectorXd& a, const Eigen::VectorXd& b, const double& radius)
+{
+  // Control points b_i = sum_k binomial(i,k)/binomial(5,k)*c_k*T^k
+  const std::vector<const Eigen::VectorXd*> c = {&blend.c0,&blend.c1,&blend.c2,&blend.c3,&blend.c4,&blend.c5};
+  const double binomial[6][6] = {{1,0,0,0,0,0},{1,1,0,0,0,0},{1,2,1,0,0,0},{1,3,3,1,0,0},{1,4,6,4,1,0},{1,5,10,10,5,1}};
+
+  for(unsigned int i=0;i<6;i++)
+  {
+    Eigen::VectorXd control_point = Eigen::VectorXd::Zero(blend.c0.size());
+    for(unsigned int k=0;k<=i;k++)
+      control_point += binomial[i][k]/binomial[5][k]*std::pow(blend.duration,k)*(*c[k]);
+
+    if(distance(control_point,a,b)>radius)
+      return false;
+  }
+
+  return true;
+}
+
+void OnlineTrajectoryGenerator::segmentLimits(const std::vector<Eigen::VectorXd>& waypoints, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration,
+                                              std::vector<Eigen::VectorXd>& dir, std::vector<double>& length, std::vector<double>& max_speed,
+                                              std::vector<double>& max_acc, std::vector<double>& speed)
+{
+  unsigned int n = waypoints.size();
+  unsigned int n_segments = (n>0)? n-1: 0;
+
+  dir.resize(n_segments);
+  length.resize(n_segments);
+  max_speed.resize(n_segments);
+  max_acc.resize(n_segments);
+  for(unsigned int k=0;k<n_segments;k++)
+  {
+    length[k] = (waypoints[k+1]-waypoints[k]).norm();
+    dir[k] = (length[k]>0.0)? Eigen::VectorXd((waypoints[k+1]-waypoints[k])/length[k]): Eigen::VectorXd::Zero(max_velocity.size());
+
+    max_speed[k] = std::numeric_limits<double>::infinity();
+    max_acc  [k] = std::numeric_limits<double>::infinity();
+    for(unsigned int j=0;j<dir[k].size();j++)
+    {
+      double u = std::abs(dir[k](j));
+      if(u>1.0e-9)
+      {
+        max_speed[k] = std::min(max_speed[k],max_velocity    (j)/u);
+        max_acc  [k] = std::min(max_acc  [k],max_acceleration(j)/u);
+      }
+    }
+  }
+
+  speed.assign(n,0.0);
+  for(unsigned int k=1;k+1<n;k++)
+  {
+    speed[k] = std::min(max_speed[k-1],max_speed[k]);
+
+    Eigen::VectorXd turn = (dir[k]-dir[k-1]).cwiseAbs();
+    double l = std::min(length[k-1],length[k]);
+    for(unsigned int j=0;j<turn.size();j++)
+    {
+      if(turn(j)>1.0e-9)
+        speed[k] = std::min(speed[k],std::sqrt(max_acceleration(j)*l/turn(j)));
+    }
+  }
+}
+
+std::vector<OnlineTrajectoryGenerator::Setpoint> OnlineTrajectoryGenerator::timePath(const std::vector<Eigen::VectorXd>& waypoints, const Eigen::VectorXd& start_velocity,
+                                                                                     std::vector<Segment>& segments) const
+{
+  Eigen::VectorXd zero = Eigen::VectorXd::Zero(max_velocity_.size());
+
+  std::vector<Eigen::VectorXd> q;
+  q.push_back(waypoints.front());
+  for(unsigned int i=1;i<waypoints.size();i++)
+  {
+    if((waypoints.at(i)-q.back()).norm()>1.0e-9)
+      q.push_back(waypoints.at(i));
+  }
+
+  unsigned int n = q.size();
+  std::vector<Setpoint> path(n);
+  segments.clear();
+  if(n == 1)
+  {
+    path.front() = Setpoint{0.0,q.front(),zero,zero};
+    return path;
+  }
+
+  std::vector<Eigen::VectorXd> dir;
+  std::vector<double> length, max_speed, max_acc, speed;
+  segmentLimits(q,max_velocity_,max_acceleration_,dir,length,max_speed,max_acc,speed);
+  speed.front() = std::max(0.0,std::min(start_velocity.dot(dir.front()),max_speed.front()));
+
+  for(unsigned int k=0;k<n-1;k++)
+    speed[k+1] = std::min(speed[k+1],std::sqrt(speed[k]*speed[k]+2.0*max_acc[k]*length[k]));
+
+  for(int k=n-2;k>=0;k--)
+    speed[k] = std::min(speed[k],std::sqrt(speed[k+1]*speed[k+1]+2.0*max_acc[k]*length[k]));
+
+  // Trapezoidal speed profile on each segment
+  path.front().time = 0.0;
+  for(unsigned int k=0;k<n-1;k++)
+  {
+    segments.push_back(Segment{q[k],dir[k],length[k],max_speed[k],max_acc[k],speed[k],speed[k+1]});
+    path[k+1].time = path[k].time+segments.back().duration();
+  }
+
+  for(unsigned int k=0;k<n;k++)
+  {
+    path[k].position = q[k];
+    if(k == 0)
+      path[k].velocity = speed[k]*dir[k];
+    else if(k == n-1)
+      path[k].velocity = zero;
+    else
+      path[k].velocity = 0.5*speed[k]*(dir[k-1]+dir[k]);
+  }
+
+  for(unsigned int k=0;k<n;k++)
+  {
+    if(k == 0)
+      path[k].acceleration = (path[k+1].velocity-path[k].velocity)/(path[k+1].time-path[k].time);
+    else if(k == n-1)
+      path[k].acceleration = zero;
+    else
+      path[k].acceleration = (path[k+1].velocity-path[k-1].velocity)/(path[k+1].time-path[k-1].time);
+
+    path[k].acceleration = path[k].acceleration.cwiseMax(-max_acceleration_).cwiseMin(max_acceleration_);
+  }
+
+  return path;
+}
+
+bool OnlineTrajectoryGenerator::generate(const std::vector<Eigen::VectorXd>& waypoints,
+                                         const Eigen::VectorXd& position,
+                                         const Eigen::VectorXd& velocity,
+                                         const Eigen::VectorXd& acceleration,
+                                         std::vector<Setpoint>& trajectory) const
+{
+  if(waypoints.empty())
+    throw std::invalid_argument("no waypoints");
+
+  if(position.size() != max_velocity_.size() || velocity.size() != max_velocity_.size() || acceleration.size() != max_velocity_.size())
+    throw std::invalid_argument("state of wrong size");
+
+  std::vector<Segment> segments;
+  std::vector<Setpoint> path = timePath(waypoints,velocity,segments);
+
+  const Setpoint& first = path.front();
+  if((position-first.position).norm()<1.0e-6 && (velocity-first.velocity).norm()<1.0e-6 && (acceleration-first.acceleration).norm()<1.0e-6)
+  {
+    trajectory = path;
+    return true;
+  }
+
+  /* Splice onto the straight initial part of the path: a point of the first segment or a waypoint up to which the path does
+   * not deviate from the chord from its start more than max_deviation. The blend must stay in the tube around the chord,
+   * widened by the distance of the current position from the path. The blend may take longer than the path to reach the
+   * splice point, the rest of the path is then delayed */
+  struct Target
+  {
+    Setpoint setpoint;
+    Eigen::VectorXd chord_end;
+    unsigned int next_waypoint; //first waypoint after the blend
+    bool inside_segment;
+  };
+
+  std::vector<Target> targets;
+  if(not segments.empty())
+  {
+    const Segment& segment = segments.front();
+    for(const double& fraction:{0.25,0.5,0.75})
+      targets.push_back(Target{segment.at(fraction*segment.length),path[1].position,1,true});
+  }
+
+  for(unsigned int m=1;m<path.size();m++)
+  {
+    bool straight = true;
+    for(unsigned int i=1;i<m && straight;i++)
+      straight = distance(path[i].position,first.position,path[m].position)<=max_deviation_;
+
+    if(not straight)
+      break;
+
+    targets.push_back(Target{path[m],path[m].position,m,false});
+  }
+
+  if(path.size() == 1)
+    targets.push_back(Target{first,first.position,0,false});
+
+  double radius = max_deviation_+distance(position,first.position,targets.front().chord_end);
+
+  Setpoint start{0.0,position,velocity,acceleration};
+  std::vector<double> stretches = {1.0,1.5,2.0,3.0};
+
+  Quintic blend;
+  int spliced = -1;
+  for(unsigned int t=0;t<targets.size() && spliced<0;t++)
+  {
+    for(const double& stretch:stretches)
+    {
+      Setpoint end = targets[t].setpoint;
+      end.time = std::max(end.time,blend_step_)*stretch;
+
+      blend = quintic(start,end);
+      if(withinLimits(blend) && withinTube(blend,first.position,targets[t].chord_end,radius))
+      {
+        spliced = t;
+        break;
+      }
+    }
+  }
+
+  if(spliced<0)
+    return false;
+
+  const Target& target = targets[spliced];
+  double shift = blend.duration-target.setpoint.time;
+
+  trajectory.clear();
+  unsigned int n_samples = std::max(std::ceil(blend.duration/blend_step_),1.0);
+  for(unsigned int i=0;i<n_samples;i++)
+    trajectory.push_back(blend.evaluate(blend.duration*i/n_samples));
+
+  if(target.inside_segment)
+  {
+    trajectory.push_back(target.setpoint);
+    trajectory.back().time += shift;
+  }
+
+  for(unsigned int k=target.next_waypoint;k<path.size();k++)
+  {
+    trajectory.push_back(path[k]);
+    trajectory.back().time += shift;
+  }
+
+  return true;
+}
+}
@@ -0,0 +1,389 @@
+#include "replanners_lib/path_library.h"
+
+namespace pathplan
+{
+
+static const uint32_t PATH_LIBRARY_MAGIC   = 0x42494c50; //"PLIB"
+static const uint32_t PATH_LIBRARY_VERSION = 1;
+
+template<typename T>
+static void writeValue(std::ofstream& file, const T& value)
+{
+  file.write(reinterpret_cast<const char*>(&value),sizeof(T));
+}
+
+template<typename T>
+static bool readValue(const char*& ptr, const char* end, T& value)
+{
+  if(ptr+sizeof(T)>end)
+    return false;
+
+  std::memcpy(&value,ptr,sizeof(T));
+  ptr += sizeof(T);
+
+  return true;
+}
+
+/* 64 bit FNV-1a, stable across compilers and standard libraries (unlike std::hash), so that the library files keep their names */
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME  = 1099511628211ULL;
+
+static uint64_t fnv1a(const void* data, const size_t& size, uint64_t hash = FNV_OFFSET)
+{
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for(size_t i=0;i<size;i++)
+  {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+
+  return hash;
+}
+
+/* Size on file of a node (configuration, parent index and cost) and the minimum size of a path (two nodes, both in the path) */
+static size_t nodeSize(const unsigned int& dof)
+{
+  return dof*sizeof(double)+sizeof(int32_t)+sizeof(double);
+}
+
+static size_t minPathSize(const unsigned int& dof)
+{
+  return sizeof(uint32_t)+2*nodeSize(dof)+sizeof(uint32_t)+2*sizeof(int32_t);
+}
+
+static void writeConf(std::ofstream& file, const Eigen::VectorXd& conf)
+{
+  file.write(reinterpret_cast<const char*>(conf.data()),conf.size()*sizeof(double));
+}
+
+static bool readConf(const char*& ptr, const char* end, const unsigned int& dof, Eigen::VectorXd& conf)
+{
+  if(ptr+dof*sizeof(double)>end)
+    return false;
+
+  conf.resize(dof);
+  std::memcpy(conf.data(),ptr,dof*sizeof(double));
+  ptr += dof*sizeof(double);
+
+  return true;
+}
+
+PathLibrary::PathLibrary(const std::string& directory,
+                         const std::string& group_name):
+  directory_(directory),
+  group_name_(group_name)
+{
+  boost::filesystem::create_directories(directory_);
+}
+
+uint64_t PathLibrary::sceneHash(const moveit_msgs::PlanningSceneWorld& world)
+{
+  /* Only the static scene: the collision objects, in order of id since the scene lists them in no particular order.
+   * The octomap is sensor data and it is left out, as the stamps and the operations of the messages */
+  std::vector<moveit_msgs::CollisionObject> objects = world.collision_objects;
+  std::sort(objects.begin(),objects.end(),[](const moveit_msgs::CollisionObject& obj1, const moveit_msgs::CollisionObject& obj2){
+    return obj1.id<obj2.id;
+  });
+
+  uint64_t hash = FNV_OFFSET;
+  std::vector<uint8_t> buffer;
+  for(moveit_msgs::CollisionObject& obj:objects)
+  {
+    obj.header.seq = 0;
+    obj.header.stamp = ros::Time();
+    obj.operation = moveit_msgs::CollisionObject::ADD;
+
+    uint32_t size = ros::serialization::serializationLength(obj);
+    buffer.resize(size);
+
+    ros::serialization::OStream stream(buffer.data(),size);
+    ros::serialization::serialize(stream,obj);
+
+    hash = fnv1a(buffer.data(),size,hash);
+  }
+
+  return hash;
+}
+
+std::string PathLibrary::fileName(const Eigen::VectorXd& start_conf, const Eigen::VectorXd& goal_conf, const uint64_t& scene_hash) const
+{
+  uint64_t key = fnv1a(start_conf.data(),start_conf.size()*sizeof(double));
+  key = fnv1a(goal_conf.data(),goal_conf.size()*sizeof(double),key);
+  key = fnv1a(&scene_hash,sizeof(scene_hash),key);
+
+  std::stringstream name;
+  name<<group_name_<<"_"<<std::hex<<key<<".plib";
+
+  return (boost::filesystem::path(directory_)/name.str()).string();
+}
+
+void PathLibrary::writePath(std::ofstream& file, const PathPtr& path) const
+{
+  std::vector<NodePtr> path_nodes = path->getNodes();
+  std::vector<NodePtr> nodes;
+  std::vector<int32_t> parents;
+  std::vector<double> costs;
+  std::unordered_map<Node*,int32_t> idx;
+
+  // The whole tree is stored only if the path starts from its root, otherwise only the path
+  TreePtr tree = path->getTree();
+  if(tree && tree->getRoot() == path_nodes.front())
+  {
+    nodes = tree->getNodesConst();
+    for(unsigned int i=0;i<nodes.size();i++)
+      idx[nodes.at(i).get()] = i;
+
+    for(const NodePtr& n:nodes)
+    {
+      std::unordered_map<Node*,int32_t>::iterator it = idx.end();
+      if(n->getParentConnectionsSize()>0)
+        it = idx.find(n->parentConnection(0)->getParent().get());
+
+      parents.push_back((it != idx.end())? it->second:-1);
+      costs.push_back((it != idx.end())? n->parentConnection(0)->getCost():0.0);
+    }
+  }
+  else
+  {
+    nodes = path_nodes;
+    for(unsigned int i=0;i<nodes.size();i++)
+    {
+      idx[nodes.at(i).get()] = i;
+      parents.push_back((int32_t) i-1);
+      costs.push_back((i>0)? path->getConnectionsConst().at(i-1)->getCost():0.0);
+    }
+  }
+
+  writeValue<uint32_t>(file,nodes.size());
+  for(unsigned int i=0;i<nodes.size();i++)
+  {
+    writeConf(file,nodes.at(i)->getConfiguration());
+    writeValue<int32_t>(file,parents.at(i));
+    writeValue<double>(file,costs.at(i));
+  }
+
+  writeValue<uint32_t>(file,path_nodes.size());
+  for(const NodePtr& n:path_nodes)
+    writeValue<int32_t>(file,idx.at(n.get()));
+}
+
+bool PathLibrary::save(const std::vector<PathPtr>& paths, const Eigen::VectorXd& start_conf, const Eigen::VectorXd& goal_conf,
+                       const uint64_t& scene_hash, const double& max_distance) const
+{
+  std::string file_name = fileName(start_conf,goal_conf,scene_hash);
+  std::string tmp_file_name = file_name+".tmp";
+
+  std::ofstream file(tmp_file_name,std::ios::binary|std::ios::trunc);
+  if(not file.is_open())
+  {
+    ROS_ERROR_STREAM("Unable to open "<<tmp_file_name);
+    return false;
+  }
+
+  writeValue<uint32_t>(file,PATH_LIBRARY_MAGIC);
+  writeValue<uint32_t>(file,PATH_LIBRARY_VERSION);
+  writeValue<uint64_t>(file,scene_hash);
+  writeValue<uint32_t>(file,start_conf.size());
+  writeValue<uint32_t>(file,group_name_.size());
+  file.write(group_name_.data(),group_name_.size());
+  writeConf(file,start_conf);
+  writeConf(file,goal_conf);
+  writeValue<double>(file,max_distance);
+  writeValue<uint32_t>(file,paths.size());
+
+  for(const PathPtr& p:paths)
+    writePath(file,p);
+
+  file.close();
+  if(file.fail())
+  {
+    ROS_ERROR_STREAM("Error writing "<<tmp_file_name);
+    return false;
+  }
+
+  boost::filesystem::rename(tmp_file_name,file_name);  //atomic, a concurrent reader never sees a partial library
+
+  return true;
+}
+
+PathPtr PathLibrary::readPath(const char*& ptr, const char* end, const unsigned int& dof, const double& max_distance,
+                              const MetricsPtr& metrics, const CollisionCheckerPtr& checker) const
+{
+  uint32_t n_nodes;
+  if(not readValue(ptr,end,n_nodes) || n_nodes<2)
+    return nullptr;
+
+  if(n_nodes>(size_t)(end-ptr)/nodeSize(dof))  //corrupted count, do not allocate it
+    return nullptr;
+
+  std::vector<NodePtr> nodes(n_nodes);
+  std::vector<int32_t> parents(n_nodes);
+  std::vector<double> costs(n_nodes);
+
+  Eigen::VectorXd conf;
+  for(unsigned int i=0;i<n_nodes;i++)
+  {
+    if(not (readConf(ptr,end,dof,conf) && readValue(ptr,end,parents.at(i)) && readValue(ptr,end,costs.at(i))))
+      return nullptr;
+
+    nodes.at(i) = std::make_shared<Node>(conf);
+  }
+
+  for(unsigned int i=0;i<n_nodes;i++)
+  {
+    if(parents.at(i)<0)
+      continue;
+
+    if(parents.at(i)>=(int32_t) n_nodes)
+      return nullptr;
+
+    ConnectionPtr conn = std::make_shared<Connection>(nodes.at(parents.at(i)),nodes.at(i),false);
+    conn->setCost(costs.at(i));
+    conn->add();
+  }
+
+  uint32_t path_size;
+  if(not readValue(ptr,end,path_size) || path_size<2 || path_size>(size_t)(end-ptr)/sizeof(int32_t))
+    return nullptr;
+
+  std::vector<int32_t> path_idx(path_size);
+  for(unsigned int i=0;i<path_size;i++)
+  {
+    if(not readValue(ptr,end,path_idx.at(i)) || path_idx.at(i)<0 || path_idx.at(i)>=(int32_t) n_nodes)
+      return nullptr;
+  }
+
+  std::vector<ConnectionPtr> connections;
+  for(unsigned int i=1;i<path_size;i++)
+  {
+    NodePtr child = nodes.at(path_idx.at(i));
+    if(child->getParentConnectionsSize() != 1 || child->parentConnection(0)->getParent() != nodes.at(path_idx.at(i-1)))
+      return nullptr;
+
+    connections.push_back(child->parentConnection(0));
+  }
+
+  TreePtr tree = std::make_shared<Tree>(nodes.at(path_idx.front()),max_distance,checker,metrics);
+  tree->addBranch(connections);
+
+  std::unordered_set<Node*> branch_nodes;
+  for(const int32_t& i:path_idx)
+    branch_nodes.insert(nodes.at(i).get());
+
+  for(const NodePtr& n:nodes)
+  {
+    if(branch_nodes.find(n.get()) == branch_nodes.end())
+      tree->addNode(n,false);
+  }
+
+  PathPtr path = std::make_shared<Path>(connections,metrics,checker);
+  path->setTree(tree);
+
+  return path;
+}
+
+std::vector<PathPtr> PathLibrary::load(const Eigen::VectorXd& start_conf, const Eigen::VectorXd& goal_conf, const uint64_t& scene_hash,
+                                       const MetricsPtr& metrics, const CollisionCheckerPtr& checker, const bool& validate) const
+{
+  std::vector<PathPtr> paths;
+  std::string file_name = fileName(start_conf,goal_conf,scene_hash);
+
+  int fd = open(file_name.c_str(),O_RDONLY);
+  if(fd<0)
+    return paths;
+
+  struct stat file_stat;
+  if(fstat(fd,&file_stat)<0 || file_stat.st_size == 0)
+  {
+    close(fd);
+    return paths;
+  }
+
+  size_t size = file_stat.st_size;
+  void* map = mmap(nullptr,size,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+
+  if(map == MAP_FAILED)
+  {
+    ROS_ERROR_STREAM("Unable to map "<<file_name);
+    return paths;
+  }
+
+  const char* ptr = static_cast<const char*>(map);
+  const char* end = ptr+size;
+
+  uint32_t magic, version, dof, group_name_size, n_paths;
+  uint64_t file_scene_hash;
+  double max_distance;
+  Eigen::VectorXd file_start_conf, file_goal_conf;
+
+  bool valid_header = readValue(ptr,end,magic) && magic == PATH_LIBRARY_MAGIC &&
+      readValue(ptr,end,version) && version == PATH_LIBRARY_VERSION &&
+      readValue(ptr,end,file_scene_hash) && file_scene_hash == scene_hash &&
+      readValue(ptr,end,dof) && dof == (uint32_t) start_conf.size() &&
+      readValue(ptr,end,group_name_size) && (ptr+group_name_size<=end) &&
+      std::string(ptr,group_name_size) == group_name_;
+
+  if(valid_header)
+  {
+    ptr += group_name_size;
+    valid_header = readConf(ptr,end,dof,file_start_conf) && file_start_conf == start_conf &&
+        readConf(ptr,end,dof,file_goal_conf) && file_goal_conf == goal_conf &&
+        readValue(ptr,end,max_distance) && readValue(ptr,end,n_paths);
+  }
+
+  if(not valid_header)
+  {
+    ROS_ERROR_STREAM("Path library "<<file_name<<" does not match the query");
+    munmap(map,size);
+    return paths;
+  }
+
+  if(n_paths>(size_t)(end-ptr)/minPathSize(dof))
+  {
+    ROS_ERROR_STREAM("Path library "<<file_name<<" is corrupted");
+    munmap(map,size);
+    return paths;
+  }
+
+  paths.resize(n_paths,nullptr);
+  for(unsigned int i=0;i<n_paths;i++)
+  {
+    paths.at(i) = readPath(ptr,end,dof,max_distance,metrics,checker);
+    if(not paths.at(i))
+    {
+      ROS_ERROR_STREAM("Path library "<<file_name<<" is corrupted");
+      break;
+    }
+  }
+
+  munmap(map,size);
+
+  if(not validate)
+    return paths;
+
+  /* Validate the paths in the current scene in parallel, each one with its own checker */
+  std::vector<std::shared_future<bool>> tasks;
+  for(const PathPtr& p:paths)
+  {
+    if(not p)
+    {
+      tasks.push_back(std::async(std::launch::deferred,[]() ->bool{return false;}));
+      continue;
+    }
+
+    p->setChecker(checker->clone());
+    tasks.push_back(std::async(std::launch::async,[p]() ->bool{return p->isValid();}));
+  }
+
+  for(unsigned int i=0;i<paths.size();i++)
+  {
+    if(not tasks.at(i).get())
+      paths.at(i) = nullptr;
+    else
+      paths.at(i)->setChecker(checker);
+  }
+
+  return paths;
+}
+}
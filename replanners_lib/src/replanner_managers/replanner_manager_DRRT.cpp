@@ -13,6 +13,12 @@ ReplannerManagerDRRT::ReplannerManagerDRRT(const PathPtr &current_path,
   solver_  = tmp_solver;
 }
 
+ReplannerManagerDRRT::~ReplannerManagerDRRT()
+{
+  // The threads of a running query call the overrides of this class
+  shutdownThreads();
+}
+
 void ReplannerManagerDRRT::startReplannedPathFromNewCurrentConf(const Eigen::VectorXd& configuration)
 {
   paths_mtx_.lock();
@@ -235,4 +241,10 @@ void ReplannerManagerDRRT::initReplanner()
   replanner_ = std::make_shared<pathplan::DynamicRRT>(configuration_replan_, current_path_, time_for_repl, solver_);
 }
 
+ReplannerBasePtr ReplannerManagerDRRT::speculativeReplanner(Eigen::VectorXd& configuration, PathPtr& path)
+{
+  double time_for_repl = 0.9*dt_replan_;
+  return std::make_shared<pathplan::DynamicRRT>(configuration, path, time_for_repl, cloneSolver(path->getChecker()));
+}
+
 }
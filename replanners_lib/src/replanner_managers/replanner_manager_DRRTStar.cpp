@@ -10,6 +10,27 @@ ReplannerManagerDRRTStar::ReplannerManagerDRRTStar(const PathPtr &current_path,
   tmp_solver->importFromSolver(solver);
 
   solver_  = tmp_solver;
+
+  if(speculative_replanning_)
+  {
+    ROS_ERROR("speculative_replanning is not available for DRRTStar, disabled");
+    speculative_replanning_ = false;
+  }
+}
+
+ReplannerManagerDRRTStar::~ReplannerManagerDRRTStar()
+{
+  // The threads of a running query call the overrides of this class
+  shutdownThreads();
+}
+
+bool ReplannerManagerDRRTStar::reset(const PathPtr& current_path, const Eigen::VectorXd& goal_conf)
+{
+  if(not ReplannerManagerBase::reset(current_path,goal_conf))
+    return false;
+
+  old_current_node_ = nullptr;
+  return true;
 }
 
 void ReplannerManagerDRRTStar::startReplannedPathFromNewCurrentConf(const Eigen::VectorXd& configuration)
@@ -24,6 +24,12 @@ ReplannerManagerMARS::ReplannerManagerMARS(const PathPtr &current_path,
 
 void ReplannerManagerMARS::MARSadditionalParams()
 {
+  if(speculative_replanning_)
+  {
+    ROS_ERROR("speculative_replanning is not available for MARS, disabled");
+    speculative_replanning_ = false;
+  }
+
   if(!nh_.getParam("MARS/dt_replan_relaxed",dt_replan_relaxed_))
   {
     ROS_ERROR("MARS/dt_replan_relaxed not set, set 150% of dt_replan");
@@ -54,6 +60,71 @@ void ReplannerManagerMARS::MARSadditionalParams()
     display_other_paths_ = true;
   }
 
+  if(!nh_.getParam("MARS/gc_period",gc_period_))
+  {
+    ROS_ERROR("MARS/gc_period not set, set 0 (tree compaction disabled)");
+    gc_period_ = 0.0;
+  }
+
+  if(gc_period_>0.0)
+  {
+    if(!nh_.getParam("MARS/gc_node_budget",gc_node_budget_))
+    {
+      ROS_ERROR("MARS/gc_node_budget not set, set 2000");
+      gc_node_budget_ = 2000;
+    }
+
+    if(!nh_.getParam("MARS/gc_other_paths_to_keep",gc_other_paths_to_keep_))
+    {
+      ROS_ERROR("MARS/gc_other_paths_to_keep not set, set 3");
+      gc_other_paths_to_keep_ = 3;
+    }
+    else
+    {
+      if(gc_other_paths_to_keep_<0)
+      {
+        ROS_ERROR("MARS/gc_other_paths_to_keep can not be negative, set 0");
+        gc_other_paths_to_keep_ = 0;
+      }
+    }
+  }
+
+  if(!nh_.getParam("MARS/fallback_paths",fallback_paths_))
+  {
+    ROS_ERROR("MARS/fallback_paths not set, set false");
+    fallback_paths_ = false;
+  }
+
+  if(fallback_paths_)
+  {
+    if(!nh_.getParam("MARS/n_fallback_paths",n_fallback_paths_))
+    {
+      ROS_ERROR("MARS/n_fallback_paths not set, set 2");
+      n_fallback_paths_ = 2;
+    }
+
+    if(!nh_.getParam("MARS/max_fallback_paths",max_fallback_paths_))
+    {
+      ROS_ERROR("MARS/max_fallback_paths not set, set 5");
+      max_fallback_paths_ = 5;
+    }
+
+    if(!nh_.getParam("MARS/fallback_paths_frequency",fallback_paths_frequency_))
+    {
+      ROS_ERROR("MARS/fallback_paths_frequency not set, set 2.0");
+      fallback_paths_frequency_ = 2.0;
+    }
+    else
+    {
+      if(fallback_paths_frequency_<=0.0)
+      {
+        ROS_ERROR("MARS/fallback_paths_frequency should be positive, set 2.0");
+        fallback_paths_frequency_ = 2.0;
+      }
+    }
+
+    fallback_solver_ = cloneSolver(solver_,current_path_->getChecker()->clone());
+  }
 }
 
 void ReplannerManagerMARS::attributeInitialization()
@@ -104,7 +175,15 @@ void ReplannerManagerMARS::attributeInitialization()
     other_paths_sync_needed_.push_back(false);
   }
 
-  time_shift_ = (dt_replan_relaxed_-dt_)*K_OFFSET;
+  fallback_paths_queue_.clear();
+  fallback_paths_idx_  .clear();
+  fallback_junctions_  .clear();
+
+  other_paths_reset_ = false;
+  path_changed_ = true;
+  last_gc_time_ = ros::WallTime::now();
+
+  time_shift_ = computeTimeShift();
   t_replan_ = t_+time_shift_;
 
   double scaling = 1.0;
@@ -122,10 +201,17 @@ void ReplannerManagerMARS::attributeInitialization()
 
 bool ReplannerManagerMARS::replan()
 {
+  if(fallback_paths_)
+  {
+    evictFallbackPaths();
+    mergeFallbackPaths();
+  }
+
   double cost = replanner_->getCurrentPath()->getCostFromConf(replanner_->getCurrentConf());
-  (cost == std::numeric_limits<double>::infinity())? (replanner_->setMaxTime(0.9*dt_replan_)):
-                                                     (replanner_->setMaxTime(0.9*dt_replan_relaxed_));
+  (cost == std::numeric_limits<double>::infinity())? (replanner_->setMaxTime(0.9*adaptiveDtReplan(dt_replan_))):
+                                                     (replanner_->setMaxTime(0.9*adaptiveDtReplan(dt_replan_relaxed_)));
   bool path_changed = replanner_->replan();
+  path_changed_ = path_changed;
 
   //CHANGE WITH PATH_CHANGED?
   if(replanner_->getSuccess() && first_replanning_)  //add the initial path to the other paths
@@ -153,6 +239,344 @@ bool ReplannerManagerMARS::replan()
   return path_changed;
 }
 
+void ReplannerManagerMARS::evictFallbackPaths()
+{
+  /* The fallback paths obstructed from their junction or whose junction has been overtaken by the robot are removed
+   * from MARS, so that max_fallback_paths_ bounds the fallback paths still useful. It must be called by the replanning thread */
+  MARSPtr replanner = std::static_pointer_cast<MARS>(replanner_);
+  PathPtr current_path = replanner->getCurrentPath();
+
+  other_paths_mtx_.lock();
+  std::vector<PathPtr> stale_paths;
+  for(unsigned int i=0;i<fallback_paths_idx_.size();i++)
+  {
+    if((not current_path->findConnection(fallback_junctions_.at(i))) ||
+       other_paths_shared_.at(fallback_paths_idx_.at(i))->getCostFromConf(fallback_junctions_.at(i)) == std::numeric_limits<double>::infinity())
+      stale_paths.push_back(other_paths_.at(fallback_paths_idx_.at(i)));
+  }
+  other_paths_mtx_.unlock();
+
+  if(stale_paths.empty())
+    return;
+
+  std::vector<PathPtr> kept_paths;
+  for(const PathPtr& p:replanner->getOtherPaths())
+  {
+    if(std::find(stale_paths.begin(),stale_paths.end(),p) == stale_paths.end())
+      kept_paths.push_back(p);
+  }
+
+  replanner->setOtherPaths(kept_paths,false);
+  alignOtherPaths();
+
+  if(replanner_verbosity_)
+    ROS_BOLDWHITE_STREAM(stale_paths.size()<<" fallback paths removed from MARS");
+}
+
+void ReplannerManagerMARS::replanningIdleTime(const double& available_time)
+{
+  /* Compact tree and net in the time left by the cycle, when the path has not just been updated,
+   * so that the compaction does not delay the replanning */
+  if(gc_period_>0.0 && (not path_changed_) && available_time>0.0 && (ros::WallTime::now()-last_gc_time_).toSec()>gc_period_)
+    compactNet(available_time);
+}
+
+void ReplannerManagerMARS::mergeFallbackPaths()
+{
+  /* The fallback paths computed in background go from a configuration of the current path (junction) to the goal.
+   * MARS requires its other paths to start from the start of the paths, so the fallback path shares the tree branch from there
+   * to the junction and only its part from the junction to the goal is added to the tree. It must be called by the replanning
+   * thread, the only one allowed to modify the tree */
+  other_paths_mtx_.lock();
+  std::vector<PathPtr> candidates = fallback_paths_queue_;
+  fallback_paths_queue_.clear();
+  other_paths_mtx_.unlock();
+
+  if(candidates.empty())
+    return;
+
+  MARSPtr replanner = std::static_pointer_cast<MARS>(replanner_);
+  PathPtr current_path = replanner->getCurrentPath();
+  TreePtr tree = current_path->getTree();
+  MetricsPtr metrics = current_path->getMetrics();
+  NodePtr paths_start = replanner->getPathsStart();
+  NodePtr goal_node = replanner->getGoal();
+
+  if(not tree)
+    return;
+
+  for(const PathPtr& candidate:candidates)
+  {
+    Eigen::VectorXd junction = candidate->getWaypoints().front();
+
+    int conn_idx;
+    ConnectionPtr junction_conn = current_path->findConnection(junction,conn_idx);
+    if(not junction_conn)  //the robot has already overtaken the junction
+      continue;
+
+    /* The branch leaves the tree from the node of the current path at (or just before) the junction */
+    NodePtr branch_start;
+    ((junction-junction_conn->getChild()->getConfiguration()).norm()<TOLERANCE)?
+          (branch_start = junction_conn->getChild()):
+          (branch_start = junction_conn->getParent());
+
+    std::vector<ConnectionPtr> conns = tree->getConnectionToNode(branch_start);
+    std::vector<ConnectionPtr>::iterator it = std::find_if(conns.begin(),conns.end(),[&](const ConnectionPtr& conn) ->bool{
+        return conn->getParent() == paths_start;});
+
+    if(it == conns.end() && branch_start != paths_start)
+      continue;
+
+    conns.erase(conns.begin(),it);
+
+    std::vector<Eigen::VectorXd> waypoints = candidate->getWaypoints();
+    if((junction-branch_start->getConfiguration()).norm()<TOLERANCE)
+      waypoints.erase(waypoints.begin());
+
+    if(waypoints.empty())
+      continue;
+
+    std::vector<ConnectionPtr> branch;
+    NodePtr parent = branch_start;
+    for(unsigned int i=0;i<waypoints.size();i++)
+    {
+      bool to_goal = (i == waypoints.size()-1);
+      NodePtr child = to_goal? goal_node: std::make_shared<Node>(waypoints.at(i));
+
+      ConnectionPtr conn = std::make_shared<Connection>(parent,child,to_goal);  //the goal has already its parent in the tree
+      conn->setCost(metrics->cost(parent->getConfiguration(),child->getConfiguration()));
+      conn->add();
+
+      if(not to_goal)
+        branch.push_back(conn);
+
+      conns.push_back(conn);
+      parent = child;
+    }
+
+    if(not branch.empty())
+      tree->addBranch(branch);
+
+    PathPtr fallback_path = std::make_shared<Path>(conns,metrics,checker_replanning_);
+    fallback_path->setTree(tree);
+    replanner->addOtherPath(fallback_path,false);
+
+    other_paths_mtx_.lock();
+
+    PathPtr fallback_path_shared = fallback_path->clone();
+    fallback_path_shared->setChecker(checker_cc_);
+
+    fallback_paths_idx_.push_back(other_paths_shared_.size());
+    fallback_junctions_.push_back(junction);
+
+    other_paths_shared_.push_back(fallback_path_shared);
+    other_paths_sync_needed_.push_back(false);
+    other_paths_.push_back(fallback_path);
+
+    other_paths_mtx_.unlock();
+
+    if(replanner_verbosity_)
+      ROS_BOLDWHITE_STREAM("Fallback path added to MARS, cost from junction "<<candidate->cost());
+  }
+}
+
+void ReplannerManagerMARS::compactNet(const double& max_time)
+{
+  MARSPtr replanner = std::static_pointer_cast<MARS>(replanner_);
+
+  std::vector<NodePtr> white_list;
+  if(old_current_node_)
+    white_list.push_back(old_current_node_);
+
+  replanner->compactTree(gc_node_budget_,gc_other_paths_to_keep_,white_list,max_time);
+  last_gc_time_ = ros::WallTime::now();
+
+  alignOtherPaths();
+}
+
+void ReplannerManagerMARS::alignOtherPaths()
+{
+  /* Align the other paths of the manager to the ones kept by MARS */
+  MARSPtr replanner = std::static_pointer_cast<MARS>(replanner_);
+  std::vector<PathPtr> kept_paths = replanner->getOtherPaths();
+
+  other_paths_mtx_.lock();
+
+  std::vector<PathPtr> other_paths, other_paths_shared;
+  std::vector<bool> other_paths_sync_needed;
+  std::vector<unsigned int> fallback_paths_idx;
+  std::vector<Eigen::VectorXd> fallback_junctions;
+
+  for(unsigned int i=0;i<other_paths_.size();i++)
+  {
+    if(std::find(kept_paths.begin(),kept_paths.end(),other_paths_.at(i))>=kept_paths.end())
+      continue;
+
+    std::vector<unsigned int>::iterator it = std::find(fallback_paths_idx_.begin(),fallback_paths_idx_.end(),i);
+    if(it<fallback_paths_idx_.end())
+    {
+      fallback_paths_idx.push_back(other_paths.size());
+      fallback_junctions.push_back(fallback_junctions_.at(it-fallback_paths_idx_.begin()));
+    }
+
+    CollisionCheckerPtr checker = other_paths_shared_.at(i)->getChecker();
+    PathPtr other_path_shared = other_paths_.at(i)->clone(); //some nodes may have been removed
+    other_path_shared->setChecker(checker);
+
+    other_paths.push_back(other_paths_.at(i));
+    other_paths_shared.push_back(other_path_shared);
+    other_paths_sync_needed.push_back(false);
+  }
+
+  other_paths_              = other_paths;
+  other_paths_shared_       = other_paths_shared;
+  other_paths_sync_needed_  = other_paths_sync_needed;
+  fallback_paths_idx_       = fallback_paths_idx;
+  fallback_junctions_       = fallback_junctions;
+  other_paths_reset_        = true;  //the collision check thread copies again all the other paths
+
+  other_paths_mtx_.unlock();
+}
+
+unsigned int ReplannerManagerMARS::validFallbackPaths()
+{
+  // To be called with other_paths_mtx_ locked
+  unsigned int n_valid = 0;
+  for(unsigned int i=0;i<fallback_paths_idx_.size();i++)
+  {
+    if(other_paths_shared_.at(fallback_paths_idx_.at(i))->getCostFromConf(fallback_junctions_.at(i))<std::numeric_limits<double>::infinity())
+      n_valid++;
+  }
+
+  return n_valid;
+}
+
+void ReplannerManagerMARS::fallbackPathsThread()
+{
+  /* Use idle time to keep n_fallback_paths_ collision-free alternatives from the region ahead of the replanning
+   * configuration to the goal, so that MARS can switch to them without running a solver */
+  ros::WallRate lp(fallback_paths_frequency_);
+  double max_time = 0.9/fallback_paths_frequency_;
+
+  scene_mtx_.lock();
+  CollisionCheckerPtr checker = checker_cc_->clone();
+  scene_mtx_.unlock();
+
+  unsigned int octree_version = 0;
+  Eigen::VectorXd goal_conf = replanner_->getGoal()->getConfiguration();
+
+  trajectory_msgs::JointTrajectoryPoint pnt;
+  Eigen::VectorXd point2project(pnt_replan_.positions.size());
+
+  while((not stop_) && ros::ok())
+  {
+    lp.sleep();
+
+    if(not download_scene_info_)
+      continue;
+
+    other_paths_mtx_.lock();
+    // The replanning thread evicts the stale fallback paths, so fallback_paths_idx_ holds the useful ones
+    bool fallback_needed = ((validFallbackPaths()+fallback_paths_queue_.size())<(unsigned int) n_fallback_paths_) &&
+        ((fallback_paths_idx_.size()+fallback_paths_queue_.size())<(unsigned int) max_fallback_paths_);
+    other_paths_mtx_.unlock();
+
+    if(not fallback_needed)
+      continue;
+
+    /* The junction is one time shift ahead of the replanning configuration, in the region the
+     * replanner will reach next */
+    trj_mtx_.lock();
+    interpolator_.interpolate(ros::Duration(t_replan_+time_shift_),pnt,scaling_);
+    trj_mtx_.unlock();
+
+    for(unsigned int i=0; i<pnt.positions.size();i++)
+      point2project(i) = pnt.positions.at(i);
+
+    paths_mtx_.lock();
+    PathPtr current_path = current_path_shared_->clone();
+    paths_mtx_.unlock();
+
+    Eigen::VectorXd junction = current_path->projectOnPath(point2project);
+    if((junction-goal_conf).norm()<goal_tol_)
+      continue;
+
+    scene_mtx_.lock();
+    setWorldMsg(checker,planning_scene_diff_msg_,octree_version != octree_version_);
+    octree_version = octree_version_;
+    scene_mtx_.unlock();
+
+    if(not checker->check(junction))
+      continue;
+
+    current_path->setChecker(checker);
+    double cost2beat = current_path->getCostFromConf(junction);
+
+    PathPtr solution;
+    TreeSolverPtr solver = cloneSolver(fallback_solver_,checker);
+    NodePtr start_node = std::make_shared<Node>(junction);
+    NodePtr goal_node  = std::make_shared<Node>(goal_conf);
+
+    if(not solver->computePath(start_node,goal_node,nh_,solution,max_time,1000000))
+      continue;
+
+    if(cost2beat<std::numeric_limits<double>::infinity() && solution->cost()>=2.0*cost2beat)  //useless detour
+      continue;
+
+    other_paths_mtx_.lock();
+    fallback_paths_queue_.push_back(solution);
+    other_paths_mtx_.unlock();
+  }
+
+  ROS_BOLDCYAN_STREAM("Fallback paths thread is over");
+}
+
+ReplannerManagerMARS::~ReplannerManagerMARS()
+{
+  // The fallback paths thread uses the members of this class
+  shutdownThreads();
+
+  if(fallback_paths_thread_.joinable())
+    fallback_paths_thread_.join();
+}
+
+void ReplannerManagerMARS::launchThreads()
+{
+  ReplannerManagerBase::launchThreads();
+
+  if(fallback_paths_ && replanning_enabled_)
+    launchThread(fallback_paths_thread_,[this](){if(replanning_enabled_) fallbackPathsThread();});
+}
+
+bool ReplannerManagerMARS::reset(const PathPtr& current_path, const Eigen::VectorXd& goal_conf)
+{
+  /* The other paths of the new query are given by setOtherPaths(), before or after reset().
+   * What was derived from the other paths and from the tree of the previous query is dropped */
+  if(not ReplannerManagerBase::reset(current_path,goal_conf))
+    return false;
+
+  other_paths_mtx_.lock();
+  other_paths_shared_     .clear();
+  other_paths_sync_needed_.clear();
+  fallback_paths_queue_   .clear();
+  fallback_paths_idx_     .clear();
+  fallback_junctions_     .clear();
+  other_paths_mtx_.unlock();
+
+  other_paths_reset_ = false;
+  path_changed_      = true ;
+  first_replanning_  = true ;
+  old_current_node_  = nullptr;
+  initial_path_      = current_path;
+
+  return true;
+}
+
+double ReplannerManagerMARS::computeTimeShift()
+{
+  return (adaptiveDtReplan(dt_replan_relaxed_)-dt_)*K_OFFSET;
+}
+
 void ReplannerManagerMARS::startReplannedPathFromNewCurrentConf(const Eigen::VectorXd& configuration)
 {
   MARSPtr replanner = std::static_pointer_cast<MARS>(replanner_);
@@ -545,8 +969,15 @@ void ReplannerManagerMARS::initReplanner()
   replanner_->setDisp(disp);
 }
 
-bool ReplannerManagerMARS::checkPathTask(const PathPtr& path)
+bool ReplannerManagerMARS::checkPathTask(const PathPtr& path, const CollisionCheckerPtr& checker, const std::vector<bool>& static_validity,
+                                         const std::vector<unsigned int>& conn_ids, const bool& full_check)
 {
+  if(not full_check)
+    return checkConnectionsFromConf(path,Eigen::VectorXd(),-1,checker,conn_ids,static_validity,prioritized_path_checks_);
+
+  if(static_dynamic_split_)
+    return checkPathDynamic(path,Eigen::VectorXd(),-1,checker,static_validity);
+
   bool valid = path->isValid();
   path->cost();
 
@@ -561,12 +992,15 @@ void ReplannerManagerMARS::collisionCheckThread()
   PathPtr current_path_copy = current_path_shared_->clone();
   current_path_copy->setChecker(checker_cc_);
 
+  /* With the static/dynamic split the other paths are checked against the dynamic objects only */
+  CollisionCheckerPtr other_paths_checker = static_dynamic_split_? checker_dynamic_: checker_cc_;
+
   std::vector<PathPtr> other_paths_copy;
   std::vector<CollisionCheckerPtr> checkers;
   for(const PathPtr& p:other_paths_shared_)
   {
     PathPtr path_copy = p->clone();
-    CollisionCheckerPtr checker = checker_cc_->clone();
+    CollisionCheckerPtr checker = other_paths_checker->clone();
 
     checkers.push_back(checker);
     path_copy->setChecker(checker);
@@ -575,10 +1009,47 @@ void ReplannerManagerMARS::collisionCheckThread()
 
   int other_path_size = other_paths_copy.size();
 
+  Eigen::VectorXd goal_conf = replanner_->getGoal()->getConfiguration();
+
   ros::WallRate lp(collision_checker_thread_frequency_);
   ros::WallTime tic;
 
   moveit_msgs::PlanningScene planning_scene_msg;
+  moveit_msgs::PlanningScene dynamic_scene_msg;
+
+  /* When a path changes (or the static scene, with the static/dynamic split) its static validity and swept volumes
+   * are computed again and it is fully checked, otherwise only the connections near the changed objects are checked */
+  bool current_path_changed = true;
+  bool full_check = true;
+  std::vector<bool> other_paths_changed(other_path_size,true);
+  std::vector<bool> other_paths_full_check(other_path_size,true);
+
+  std::vector<bool> static_validity;
+  std::vector<std::vector<bool>> other_paths_static_validity;
+
+  /* With prioritized checks the connections nearest to the objects are checked first and the check stops at the first obstruction */
+  bool use_swept_volumes = swept_volume_invalidation_ || prioritized_path_checks_;
+  SweptVolumeGridPtr swept_volumes;
+  std::vector<SweptVolumeGridPtr> other_paths_swept_volumes;
+  if(use_swept_volumes)
+    swept_volumes = std::make_shared<SweptVolumeGrid>(planning_scn_cc_->getRobotModel(),group_name_,swept_volume_cell_size_,checker_resolution_,swept_volume_margin_);
+
+  /* With the obstacle prediction the current path is checked against the positions of the moving objects when the robot will traverse it */
+  ObstaclePredictorPtr predictor;
+  std::vector<CollisionCheckerPtr> predicted_checkers;
+  if(obstacle_prediction_)
+    predictor = std::make_shared<ObstaclePredictor>(prediction_horizon_,prediction_step_);
+
+  /* With a check horizon the connections of the current path reached soon are checked every cycle, the later ones less often */
+  double time_to_end = 0.0;
+  unsigned long cycle = 0;
+  std::vector<bool> pending;
+
+  std::vector<Eigen::AlignedBox3d> changed_regions;
+  std::map<std::string,moveit_msgs::CollisionObject> world_objects;
+  std::vector<moveit_msgs::AttachedCollisionObject> attached_objects;
+  Eigen::AlignedBox3d octree_region;
+  octree_region.setEmpty();
 
   while((not stop_) && ros::ok())
   {
@@ -586,6 +1057,8 @@ void ReplannerManagerMARS::collisionCheckThread()
 
     /* Update planning scene */
     ps_srv.request.components.components = 20; //moveit_msgs::PlanningSceneComponents::WORLD_OBJECT_GEOMETRY + moveit_msgs::PlanningSceneComponents::ROBOT_STATE_ATTACHED_OBJECTS
+    if(octomap_updates_)
+      ps_srv.request.components.components += moveit_msgs::PlanningSceneComponents::OCTOMAP;
 
     if(not plannning_scene_client_.call(ps_srv))
     {
@@ -594,41 +1067,104 @@ void ReplannerManagerMARS::collisionCheckThread()
       break;
     }
 
+    bool octree_changed = octomap_updates_ && updateOctree(ps_srv.response.scene.world.octomap);
+
     scene_mtx_.lock();
+    if(octree_changed || planning_scene_msg.world != ps_srv.response.scene.world)
+      world_version_++;
+
     planning_scene_msg.world = ps_srv.response.scene.world;
     planning_scene_msg.is_diff = true;
 
-    checker_cc_->setPlanningSceneMsg(planning_scene_msg);
-    for(const CollisionCheckerPtr& checker: checkers)
-      checker->setPlanningSceneMsg(planning_scene_msg);
+    setWorldMsg(checker_cc_,planning_scene_msg,octree_changed);
+    if(batch_checks_)
+      setWorldMsg(batch_checker_cc_,planning_scene_msg,octree_changed);
+
+    if(static_dynamic_split_)
+    {
+      if(splitWorld(ps_srv.response.scene.world,dynamic_scene_msg,octree_changed))
+      {
+        current_path_changed = true;
+        other_paths_changed.assign(other_paths_changed.size(),true);
+      }
+
+      for(const CollisionCheckerPtr& checker: checkers)
+        setWorldMsg(checker,dynamic_scene_msg,octree_changed);
+    }
+    else
+    {
+      for(const CollisionCheckerPtr& checker: checkers)
+        setWorldMsg(checker,planning_scene_msg,octree_changed);
+    }
     scene_mtx_.unlock();
 
+    if(obstacle_prediction_) //the octree is written only by this thread
+    {
+      predictor->update(ps_srv.response.scene.world,tic.toSec());
+      updatePredictedCheckers(predictor,ps_srv.response.scene.world,predicted_checkers,octree_changed);
+    }
+
+    if(octree_changed) //the sensor data can have changed anywhere
+    {
+      full_check = true;
+      other_paths_full_check.assign(other_paths_full_check.size(),true);
+    }
+
+    if(use_swept_volumes)
+    {
+      changed_regions = changedRegions(ps_srv.response.scene.world,world_objects,octree_changed,octree_region);
+      if(attached_objects != ps_srv.response.scene.robot_state.attached_collision_objects) //the robot itself has changed
+      {
+        attached_objects = ps_srv.response.scene.robot_state.attached_collision_objects;
+        full_check = true;
+        other_paths_full_check.assign(other_paths_full_check.size(),true);
+      }
+    }
+
     /* Update paths if they have been changed */
     trj_mtx_.lock();
     paths_mtx_.lock();
 
     current_configuration_copy = current_configuration_;
+    if(check_horizon_>0.0 || obstacle_prediction_)
+      time_to_end = std::max(trajectory_->getTrj()->getDuration()-t_,0.0)/std::max(scaling_,1.0e-3);
 
     if(current_path_sync_needed_)
     {
       current_path_copy = current_path_shared_->clone();
       current_path_copy->setChecker(checker_cc_);
       current_path_sync_needed_ = false;
+      current_path_changed = true;
     }
 
     other_paths_mtx_.lock();
-    if(other_path_size<other_paths_shared_.size())  // if the previous current path has been added, update the vector of copied paths
+    if(other_paths_reset_)  // other paths have been removed by the tree compaction
     {
-      assert(other_path_size == (other_paths_shared_.size()-1));
+      other_paths_copy.clear();
+      checkers.resize(std::min(checkers.size(),other_paths_shared_.size()));
 
-      CollisionCheckerPtr checker = checker_cc_->clone();
-      PathPtr path_copy = other_paths_shared_.back()->clone();
+      for(unsigned int i=0;i<checkers.size();i++)
+      {
+        other_paths_copy.push_back(other_paths_shared_.at(i)->clone());
+        other_paths_copy.back()->setChecker(checkers.at(i));
+      }
+
+      other_path_size = other_paths_copy.size();
+      other_paths_reset_ = false;
+      other_paths_changed.assign(other_path_size,true);
+    }
+
+    while(other_path_size<other_paths_shared_.size())  // if the previous current path or fallback paths have been added, update the vector of copied paths
+    {
+      CollisionCheckerPtr checker = other_paths_checker->clone();
+      PathPtr path_copy = other_paths_shared_.at(other_path_size)->clone();
 
       checkers.push_back(checker);
       path_copy->setChecker(checker);
       other_paths_copy.push_back(path_copy);
 
       other_path_size = other_paths_copy.size();
+      other_paths_changed.push_back(true);
     }
 
     for(unsigned int i=0;i<other_paths_shared_.size();i++)  // sync other_paths_shared with its copy
@@ -638,6 +1174,7 @@ void ReplannerManagerMARS::collisionCheckThread()
         other_paths_copy.at(i) = other_paths_shared_.at(i)->clone();
         other_paths_copy.at(i)->setChecker(checkers.at(i));
         other_paths_sync_needed_.at(i) = false;
+        other_paths_changed.at(i) = true;
       }
     }
 
@@ -645,7 +1182,40 @@ void ReplannerManagerMARS::collisionCheckThread()
     paths_mtx_.unlock();
     trj_mtx_.unlock();
 
-    if((current_configuration_copy-replanner_->getGoal()->getConfiguration()).norm()<goal_tol_)
+    if(current_path_changed)
+    {
+      if(static_dynamic_split_)
+        static_validity = staticValidity(current_path_copy);
+      if(use_swept_volumes)
+        swept_volumes->setPath(current_path_copy);
+
+      current_path_changed = false;
+      full_check = true;
+    }
+
+    other_paths_full_check     .resize(other_paths_copy.size(),true);
+    other_paths_static_validity.resize(other_paths_copy.size());
+    other_paths_swept_volumes  .resize(other_paths_copy.size());
+    for(unsigned int i=0;i<other_paths_copy.size();i++)
+    {
+      if(other_paths_changed.at(i))
+      {
+        if(static_dynamic_split_)
+          other_paths_static_validity.at(i) = staticValidity(other_paths_copy.at(i));
+        if(use_swept_volumes)
+        {
+          if(not other_paths_swept_volumes.at(i))
+            other_paths_swept_volumes.at(i) = std::make_shared<SweptVolumeGrid>(planning_scn_cc_->getRobotModel(),group_name_,swept_volume_cell_size_,checker_resolution_,swept_volume_margin_);
+
+          other_paths_swept_volumes.at(i)->setPath(other_paths_copy.at(i));
+        }
+
+        other_paths_changed.at(i) = false;
+        other_paths_full_check.at(i) = true;
+      }
+    }
+
+    if((current_configuration_copy-goal_conf).norm()<goal_tol_)
     {
       stop_ = true;
       break;
@@ -656,28 +1226,61 @@ void ReplannerManagerMARS::collisionCheckThread()
     std::vector<std::shared_future<bool>> tasks;
     for(unsigned int i=0;i<other_paths_copy.size();i++)
     {
+      std::vector<unsigned int> conn_ids;
+      bool path_full_check = (not swept_volume_invalidation_) || other_paths_full_check.at(i);
+      if(not path_full_check)
+        conn_ids = other_paths_swept_volumes.at(i)->connectionsInRegions(changed_regions);
+
+      if(prioritized_path_checks_)
+      {
+        if(path_full_check)
+        {
+          for(unsigned int j=0;j<other_paths_copy.at(i)->getConnectionsSize();j++)
+            conn_ids.push_back(j);
+        }
+
+        conn_ids = prioritizeConnections(other_paths_copy.at(i),other_paths_swept_volumes.at(i),conn_ids,changed_regions,world_objects);
+        path_full_check = false;
+      }
+
       tasks.push_back(std::async(std::launch::async,
                                  &ReplannerManagerMARS::checkPathTask,
-                                 this,other_paths_copy.at(i)));
+                                 this,other_paths_copy.at(i),checkers.at(i),other_paths_static_validity.at(i),
+                                 conn_ids,path_full_check));
+
+      other_paths_full_check.at(i) = false;
     }
 
     //current_path_copy->isValidFromConf(current_configuration_copy,checker_cc_);
     int conn_idx;
     current_path_copy->findConnection(current_configuration_copy,conn_idx);
     if(conn_idx<0)
+    {
+      //the changes of this cycle have not been checked
+      full_check = true;
+      other_paths_full_check.assign(other_paths_full_check.size(),true);
       continue;
+    }
     else
-      current_path_copy->isValidFromConf(current_configuration_copy,conn_idx,checker_cc_);
+      checkCurrentPath(current_path_copy,current_configuration_copy,conn_idx,time_to_end,predictor,predicted_checkers,
+                       swept_volumes,changed_regions,world_objects,static_validity,cycle,pending,full_check);
 
     for(unsigned int i=0; i<tasks.size();i++)
+    {
       tasks.at(i).wait();  //wait for the end of each task
 
+      if(prioritized_path_checks_ && not tasks.at(i).get())
+        other_paths_full_check.at(i) = true;
+    }
+
     /* Update the cost of the paths */
     scene_mtx_.lock();
     if(uploadPathsCost(current_path_copy,other_paths_copy))
     {
       planning_scene_msg_.world = ps_srv.response.scene.world;  //not diff,it contains all pln scn info but only world is updated
       planning_scene_diff_msg_ = planning_scene_msg;            //diff, contains only world
+      if(obstacle_prediction_) //the replanner avoids the positions the moving objects will occupy within the prediction horizon
+        planning_scene_diff_msg_.world = predictor->predict(ps_srv.response.scene.world,0.0,prediction_horizon_);
 
       download_scene_info_ = true;      //dowloadPathCost can be called because the scene and path cost are referred now to the last path found
 
@@ -702,6 +1305,8 @@ bool ReplannerManagerMARS::uploadPathsCost(const PathPtr& current_path_updated_c
   paths_mtx_.lock();
   if(not current_path_sync_needed_)
   {
+    double cost_before_update = current_path_shared_->getCostFromConf(current_configuration_);
+
     std::vector<ConnectionPtr> current_path_conns      = current_path_shared_     ->getConnections();
     std::vector<ConnectionPtr> current_path_copy_conns = current_path_updated_copy->getConnections();
 
@@ -713,6 +1318,9 @@ bool ReplannerManagerMARS::uploadPathsCost(const PathPtr& current_path_updated_c
       current_path_conns.at(j)->setCost(current_path_copy_conns.at(j)->getCost());
     }
     current_path_shared_->cost();
+
+    if(current_path_shared_->getCostFromConf(current_configuration_)>cost_before_update)
+      path_cost_increased_ = true;
   }
   else
     updated = false;
@@ -723,6 +1331,12 @@ bool ReplannerManagerMARS::uploadPathsCost(const PathPtr& current_path_updated_c
   other_paths_mtx_.lock();
   for(unsigned int i=0;i<other_paths_updated_copy.size();i++)
   {
+    if(other_paths_reset_ || i>=other_paths_shared_.size())  //copies refer to other paths removed in the meantime
+    {
+      updated = false;
+      break;
+    }
+
     if(not other_paths_sync_needed_.at(i))
     {
       std::vector<ConnectionPtr> path_conns      = other_paths_shared_     .at(i)->getConnections();
@@ -801,7 +1415,10 @@ bool ReplannerManagerMARS::updateTrajectory()
 
 //  trj_path->simplify(0.0005);
   trj_path->removeNodes(1e-03); //toll 1e-03
-  trj_path->resample(max_distance/5.0);
+  if(adaptive_resampling_)
+    trj_path = adaptiveResample(trj_path,max_distance/5.0);
+  else
+    trj_path->resample(max_distance/5.0);
 
   // Get robot status at t_+time starting at the beginning of trajectory update
   // to have a smoother transition from current trajectory to the new one
@@ -810,6 +1427,9 @@ bool ReplannerManagerMARS::updateTrajectory()
 
   trajectory_->setPath(trj_path);
   robot_trajectory::RobotTrajectoryPtr trj= trajectory_->fromPath2Trj(pnt);
+  if(not trj)
+    return false;
+
   moveit_msgs::RobotTrajectory tmp_trj_msg;
   trj->getRobotTrajectoryMsg(tmp_trj_msg);
 
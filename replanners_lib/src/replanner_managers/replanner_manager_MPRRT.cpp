@@ -15,6 +15,12 @@ ReplannerManagerMPRRT::ReplannerManagerMPRRT(const PathPtr &current_path,
   additionalParams();
 }
 
+ReplannerManagerMPRRT::~ReplannerManagerMPRRT()
+{
+  // The threads of a running query call the overrides of this class
+  shutdownThreads();
+}
+
 void ReplannerManagerMPRRT::additionalParams()
 {
   if(!nh_.getParam("MPRRT/n_threads_replan",n_threads_replan_))
@@ -124,4 +130,10 @@ void ReplannerManagerMPRRT::initReplanner()
   replanner_ = std::make_shared<pathplan::MPRRT>(configuration_replan_, current_path_, time_for_repl, solver_,n_threads_replan_);
 }
 
+ReplannerBasePtr ReplannerManagerMPRRT::speculativeReplanner(Eigen::VectorXd& configuration, PathPtr& path)
+{
+  double time_for_repl = 0.9*dt_replan_;
+  return std::make_shared<pathplan::MPRRT>(configuration, path, time_for_repl, cloneSolver(path->getChecker()),n_threads_replan_);
+}
+
 }
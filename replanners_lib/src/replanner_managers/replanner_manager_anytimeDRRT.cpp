@@ -13,6 +13,12 @@ ReplannerManagerAnytimeDRRT::ReplannerManagerAnytimeDRRT(const PathPtr &current_
   solver_  = tmp_solver;
 }
 
+ReplannerManagerAnytimeDRRT::~ReplannerManagerAnytimeDRRT()
+{
+  // The threads of a running query call the overrides of this class
+  shutdownThreads();
+}
+
 bool ReplannerManagerAnytimeDRRT::haveToReplan(const bool path_obstructed)
 {
   return alwaysReplan();
@@ -23,4 +29,10 @@ void ReplannerManagerAnytimeDRRT::initReplanner()
   double time_for_repl = 0.9*dt_replan_;
   replanner_ = std::make_shared<pathplan::AnytimeDynamicRRT>(configuration_replan_, current_path_, time_for_repl, solver_);
 }
+
+ReplannerBasePtr ReplannerManagerAnytimeDRRT::speculativeReplanner(Eigen::VectorXd& configuration, PathPtr& path)
+{
+  double time_for_repl = 0.9*dt_replan_;
+  return std::make_shared<pathplan::AnytimeDynamicRRT>(configuration, path, time_for_repl, cloneSolver(path->getChecker()));
+}
 }
@@ -12,6 +12,12 @@ ReplannerManagerBase::ReplannerManagerBase(const PathPtr &current_path,
   nh_           = nh    ;
 
   replanning_enabled_ = true;
+  resources_initialized_ = false;
+
+  query_id_ = 0;
+  n_threads_ = 0;
+  running_threads_ = 0;
+  shutdown_ = false;
 
   fromParam();
   subscribeTopicsAndServices();
@@ -19,6 +25,7 @@ ReplannerManagerBase::ReplannerManagerBase(const PathPtr &current_path,
 
 ReplannerManagerBase::~ReplannerManagerBase()
 {
+  shutdownThreads();
 }
 
 void ReplannerManagerBase::fromParam()
@@ -68,6 +75,247 @@ void ReplannerManagerBase::fromParam()
     }
   }
 
+  if(!nh_.getParam("adaptive_time_shift",adaptive_time_shift_))
+    adaptive_time_shift_ = false;
+  else if(adaptive_time_shift_)
+  {
+    if(!nh_.getParam("latency_window_size",latency_window_size_))
+    {
+      ROS_ERROR("latency_window_size not set, set 50");
+      latency_window_size_ = 50;
+    }
+    if(latency_window_size_<1)
+    {
+      ROS_ERROR("latency_window_size can not be less than 1, set 1");
+      latency_window_size_ = 1;
+    }
+    if(!nh_.getParam("latency_percentile",latency_percentile_))
+    {
+      ROS_ERROR("latency_percentile not set, set 0.95");
+      latency_percentile_ = 0.95;
+    }
+    latency_percentile_ = std::min(std::max(latency_percentile_,0.0),1.0);
+
+    if(!nh_.getParam("latency_margin",latency_margin_))
+    {
+      ROS_ERROR("latency_margin not set, set 1.2");
+      latency_margin_ = 1.2;
+    }
+    if(latency_margin_<=1.0/0.9)
+    {
+      // Replannings get 90% of the estimated time, the estimate grows back only if the margin compensates for it
+      ROS_ERROR("latency_margin must be greater than 1/0.9, set 1.2");
+      latency_margin_ = 1.2;
+    }
+    if(!nh_.getParam("dt_replan_min",dt_replan_min_))
+    {
+      ROS_ERROR("dt_replan_min not set, set 20%% of dt_replan");
+      dt_replan_min_ = 0.2*dt_replan_;
+    }
+    dt_replan_min_ = std::min(dt_replan_min_,dt_replan_);
+  }
+
+  if(!nh_.getParam("demand_driven_replanning",demand_driven_replanning_))
+    demand_driven_replanning_ = false;
+  else if(demand_driven_replanning_)
+  {
+    if(!nh_.getParam("min_improvement_period",min_improvement_period_))
+    {
+      ROS_ERROR("min_improvement_period not set, set 0.1");
+      min_improvement_period_ = 0.1;
+    }
+    if(!nh_.getParam("max_improvement_period",max_improvement_period_))
+    {
+      ROS_ERROR("max_improvement_period not set, set 2.0");
+      max_improvement_period_ = 2.0;
+    }
+    if(max_improvement_period_<min_improvement_period_)
+    {
+      ROS_ERROR("max_improvement_period can not be less than min_improvement_period, set equal to it");
+      max_improvement_period_ = min_improvement_period_;
+    }
+  }
+
+  if(!nh_.getParam("speculative_replanning",speculative_replanning_))
+    speculative_replanning_ = false;
+  else if(speculative_replanning_)
+  {
+    if(!nh_.getParam("speculative_offsets",speculative_offsets_))
+    {
+      ROS_ERROR("speculative_offsets not set, set [1.0, 1.5, 2.0]");
+      speculative_offsets_ = {1.0,1.5,2.0};
+    }
+    if(speculative_offsets_.empty())
+    {
+      ROS_ERROR("speculative_offsets empty, speculative replanning disabled");
+      speculative_replanning_ = false;
+    }
+    std::sort(speculative_offsets_.begin(),speculative_offsets_.end());
+  }
+
+  if(!nh_.getParam("sdf_checker",sdf_checker_))
+    sdf_checker_ = false;
+  else if(sdf_checker_)
+  {
+    if(!nh_.getParam("sdf/resolution",sdf_resolution_))
+    {
+      ROS_ERROR("sdf/resolution not set, set 0.02");
+      sdf_resolution_ = 0.02;
+    }
+    if(!nh_.getParam("sdf/truncation",sdf_truncation_))
+    {
+      ROS_ERROR("sdf/truncation not set, set 0.3");
+      sdf_truncation_ = 0.3;
+    }
+    if(!nh_.getParam("sdf/workspace_lb",sdf_workspace_lb_) || sdf_workspace_lb_.size() != 3)
+    {
+      ROS_ERROR("sdf/workspace_lb not set, set [-1.5, -1.5, -0.5]");
+      sdf_workspace_lb_ = {-1.5,-1.5,-0.5};
+    }
+    if(!nh_.getParam("sdf/workspace_ub",sdf_workspace_ub_) || sdf_workspace_ub_.size() != 3)
+    {
+      ROS_ERROR("sdf/workspace_ub not set, set [1.5, 1.5, 2.0]");
+      sdf_workspace_ub_ = {1.5,1.5,2.0};
+    }
+    if(!nh_.getParam("sdf/self_collisions",sdf_self_collisions_))
+    {
+      ROS_ERROR("sdf/self_collisions not set, set true");
+      sdf_self_collisions_ = true;
+    }
+
+    //spheres: [x,y,z,radius] in the frame of the corresponding sphere_links element, if not set one sphere per link is used
+    nh_.getParam("sdf/sphere_links",sdf_sphere_links_);
+    nh_.getParam("sdf/spheres",sdf_spheres_);
+    if(sdf_spheres_.size() != 4*sdf_sphere_links_.size())
+    {
+      ROS_ERROR("sdf/spheres must contain [x,y,z,radius] for each element of sdf/sphere_links, one sphere per link will be used");
+      sdf_sphere_links_.clear();
+      sdf_spheres_.clear();
+    }
+  }
+
+  if(!nh_.getParam("continuous_checker",continuous_checker_))
+    continuous_checker_ = false;
+  else if(continuous_checker_)
+  {
+    if(sdf_checker_)
+    {
+      ROS_ERROR("sdf_checker and continuous_checker both set, the sdf checker will be used");
+      continuous_checker_ = false;
+    }
+    else if(!nh_.getParam("continuous/self_collisions",continuous_self_collisions_))
+    {
+      ROS_ERROR("continuous/self_collisions not set, set true");
+      continuous_self_collisions_ = true;
+    }
+  }
+
+  if(!nh_.getParam("batch_checks",batch_checks_))
+    batch_checks_ = false;
+
+  if(!nh_.getParam("octomap_updates",octomap_updates_))
+    octomap_updates_ = false;
+
+  totg_path_tolerance_ = checker_resolution_;
+  totg_resample_dt_ = 0.1;
+
+  if(!nh_.getParam("time_parameterization",time_parameterization_))
+    time_parameterization_ = "iterative_parabolic";
+  else if(time_parameterization_ == "time_optimal")
+  {
+    if(!nh_.getParam("time_optimal/path_tolerance",totg_path_tolerance_))
+    {
+      ROS_ERROR_STREAM("time_optimal/path_tolerance not set, set "<<checker_resolution_);
+      totg_path_tolerance_ = checker_resolution_;
+    }
+    else if(totg_path_tolerance_>checker_resolution_)
+    {
+      ROS_WARN_STREAM("time_optimal/path_tolerance greater than checker_resolution, the blended corners would not be checked, set "<<checker_resolution_);
+      totg_path_tolerance_ = checker_resolution_;
+    }
+
+    if(!nh_.getParam("time_optimal/resample_dt",totg_resample_dt_))
+    {
+      ROS_ERROR("time_optimal/resample_dt not set, set 0.1");
+      totg_resample_dt_ = 0.1;
+    }
+  }
+
+  if(!nh_.getParam("adaptive_resampling",adaptive_resampling_))
+    adaptive_resampling_ = false;
+
+  if(!nh_.getParam("online_trajectory_generator",online_trajectory_generator_))
+    online_trajectory_generator_ = false;
+  else if(online_trajectory_generator_)
+  {
+    if(!nh_.getParam("otg/max_jerk",otg_max_jerk_))
+    {
+      ROS_ERROR("otg/max_jerk not set, set 50.0");
+      otg_max_jerk_ = 50.0;
+    }
+
+    if(!nh_.getParam("otg/max_deviation",otg_max_deviation_))
+    {
+      ROS_ERROR("otg/max_deviation not set, set 0.01");
+      otg_max_deviation_ = 0.01;
+    }
+  }
+
+  if(!nh_.getParam("static_dynamic_split",static_dynamic_split_))
+    static_dynamic_split_ = false;
+
+  if(!nh_.getParam("swept_volume_invalidation",swept_volume_invalidation_))
+    swept_volume_invalidation_ = false;
+
+  if(!nh_.getParam("prioritized_path_checks",prioritized_path_checks_))
+    prioritized_path_checks_ = false;
+
+  if(swept_volume_invalidation_ || prioritized_path_checks_)
+  {
+    if(!nh_.getParam("swept_volume/cell_size",swept_volume_cell_size_))
+    {
+      ROS_ERROR("swept_volume/cell_size not set, set 0.1");
+      swept_volume_cell_size_ = 0.1;
+    }
+    if(!nh_.getParam("swept_volume/margin",swept_volume_margin_))
+    {
+      ROS_ERROR("swept_volume/margin not set, set 0.05");
+      swept_volume_margin_ = 0.05;
+    }
+  }
+
+  if(!nh_.getParam("check_horizon",check_horizon_))
+    check_horizon_ = 0.0;
+  else if(check_horizon_>0.0)
+  {
+    if(!nh_.getParam("check_max_period",check_max_period_))
+    {
+      ROS_ERROR("check_max_period not set, set 8");
+      check_max_period_ = 8;
+    }
+    if(check_max_period_<1)
+      check_max_period_ = 1;
+  }
+
+  if(!nh_.getParam("obstacle_prediction",obstacle_prediction_))
+    obstacle_prediction_ = false;
+  else if(obstacle_prediction_)
+  {
+    if(!nh_.getParam("prediction/horizon",prediction_horizon_))
+    {
+      ROS_ERROR("prediction/horizon not set, set 2.0");
+      prediction_horizon_ = 2.0;
+    }
+    if(!nh_.getParam("prediction/step",prediction_step_))
+    {
+      ROS_ERROR("prediction/step not set, set 0.25");
+      prediction_step_ = 0.25;
+    }
+
+    if(static_dynamic_split_ || swept_volume_invalidation_ || prioritized_path_checks_ || check_horizon_>0.0 || batch_checks_)
+      ROS_WARN("obstacle_prediction set, static_dynamic_split, swept_volume_invalidation, prioritized_path_checks, check_horizon and batch_checks will not be used to check the current path");
+  }
+
   if(!nh_.getParam("goal_tol",goal_tol_))
     goal_tol_ = 1.0e-06;
   else
@@ -87,6 +335,34 @@ void ReplannerManagerBase::fromParam()
     unscaled_joint_target_topic_ = "/unscaled_joint_target_replanning";
   if(!nh_.getParam("scaling",scaling_from_param_))
     scaling_from_param_ = 1.0;
+
+  if(!nh_.getParam("shared_memory_target",shared_memory_target_))
+    shared_memory_target_ = false;
+  else if(shared_memory_target_)
+  {
+    if(!nh_.getParam("shared_memory/name",shared_memory_name_))
+      shared_memory_name_ = "/replanner_joint_target";
+    if(!nh_.getParam("shared_memory/capacity",shared_memory_capacity_))
+    {
+      ROS_ERROR("shared_memory/capacity not set, set 256");
+      shared_memory_capacity_ = 256;
+    }
+  }
+
+  if(!nh_.getParam("setpoint_streaming",setpoint_streaming_))
+    setpoint_streaming_ = false;
+  else if(setpoint_streaming_)
+  {
+    if(!nh_.getParam("streaming/horizon",streaming_horizon_))
+    {
+      ROS_ERROR("streaming/horizon not set, set 0.1");
+      streaming_horizon_ = 0.1;
+    }
+    if(!nh_.getParam("streaming/topic",chunk_topic_))
+      chunk_topic_ = "/joint_target_chunk_replanning";
+    if(!nh_.getParam("streaming/unscaled_topic",unscaled_chunk_topic_))
+      unscaled_chunk_topic_ = "/unscaled_joint_target_chunk_replanning";
+  }
   if(!nh_.getParam("display_timing_warning",display_timing_warning_))
     display_timing_warning_ = false;
   if(!nh_.getParam("display_replanning_success", display_replanning_success_))
@@ -141,48 +417,138 @@ void ReplannerManagerBase::attributeInitialization()
   current_path_sync_needed_        = false;
   spline_order_                    = 3    ;
   replanning_time_                 = 0.0  ;
+  trajectory_time_                 = 0.0  ;
   scaling_                         = 1.0  ;
   real_time_                       = 0.0  ;
   t_                               = 0.0  ;
   dt_                              = 1.0/trj_exec_thread_frequency_;
-  time_shift_                      = dt_replan_*K_OFFSET           ;
+  time_shift_                      = computeTimeShift()            ;
   t_replan_                        = t_+time_shift_                ;
   replanning_thread_frequency_     = 100.0                         ;
   global_override_                 = 0.0                           ;
 
+  replanning_latencies_.clear();
+
+  world_version_                   = 0    ;
+  last_world_version_              = 0    ;
+  octree_version_                  = 0    ;
+  speculative_octree_version_      = 0    ;
+  path_cost_increased_             = false;
+  last_replanning_time_            = ros::WallTime::now();
+
+  if(demand_driven_replanning_)
+    improvement_period_ = min_improvement_period_;
+
   if(group_name_.empty())
     throw std::invalid_argument("group name not set");
 
-  robot_model_loader::RobotModelLoader robot_model_loader("robot_description");
-  robot_model::RobotModelPtr kinematic_model = robot_model_loader.getModel();
-
   moveit_msgs::GetPlanningScene ps_srv;
   if(not plannning_scene_client_.call(ps_srv))
     throw std::runtime_error("call to planning scene srv not ok");
 
-  planning_scn_cc_ = std::make_shared<planning_scene::PlanningScene>(kinematic_model);
-  if (not planning_scn_cc_->setPlanningSceneMsg(ps_srv.response.scene))
-    throw std::runtime_error("unable to update planning scene");
-  planning_scn_replanning_ = planning_scn_cc_->diff();
-
   planning_scene_msg_              = ps_srv.response.scene;
   planning_scene_diff_msg_.is_diff = true;
   planning_scene_diff_msg_.world   = ps_srv.response.scene.world;
 
-  robot_state::RobotState state(planning_scn_cc_->getCurrentState());
-  const robot_state::JointModelGroup* joint_model_group = state.getJointModelGroup(group_name_);
-  std::vector<std::string> joint_names = joint_model_group->getActiveJointModelNames();
+  if(not resources_initialized_)
+  {
+    /* Robot model, planning scenes and checkers are created only once and kept by reset() */
+    robot_model_loader::RobotModelLoader robot_model_loader("robot_description");
+    robot_model::RobotModelPtr kinematic_model = robot_model_loader.getModel();
 
-  current_path_shared_ = current_path_->clone();
+    planning_scn_cc_ = std::make_shared<planning_scene::PlanningScene>(kinematic_model);
+    if (not planning_scn_cc_->setPlanningSceneMsg(ps_srv.response.scene))
+      throw std::runtime_error("unable to update planning scene");
+    planning_scn_replanning_ = planning_scn_cc_->diff();
+
+    robot_state::RobotState state(planning_scn_cc_->getCurrentState());
+    const robot_state::JointModelGroup* joint_model_group = state.getJointModelGroup(group_name_);
+    joint_names_ = joint_model_group->getActiveJointModelNames();
+    model_frame_ = kinematic_model->getModelFrame();
+
+    if(sdf_checker_)
+    {
+      /* The distance field is shared by the checkers until one of them needs to update it */
+      distance_field_ = std::make_shared<pathplan::DistanceField>(Eigen::Vector3d(sdf_workspace_lb_.data()),Eigen::Vector3d(sdf_workspace_ub_.data()),sdf_resolution_,sdf_truncation_);
+      distance_field_->setWorldMsg(ps_srv.response.scene.world,false,planning_scn_cc_);
+
+      Eigen::Matrix4Xd spheres = Eigen::Map<Eigen::Matrix4Xd>(sdf_spheres_.data(),4,sdf_spheres_.size()/4);
+      checker_cc_         = std::make_shared<pathplan::SdfCollisionChecker>(planning_scn_cc_,        group_name_,distance_field_,sdf_sphere_links_,spheres,sdf_self_collisions_,checker_resolution_);
+      checker_replanning_ = std::make_shared<pathplan::SdfCollisionChecker>(planning_scn_replanning_,group_name_,distance_field_,sdf_sphere_links_,spheres,sdf_self_collisions_,checker_resolution_);
+    }
+    else if(continuous_checker_)
+    {
+      checker_cc_         = std::make_shared<pathplan::ContinuousCollisionChecker>(planning_scn_cc_,        group_name_,continuous_self_collisions_,checker_resolution_);
+      checker_replanning_ = std::make_shared<pathplan::ContinuousCollisionChecker>(planning_scn_replanning_,group_name_,continuous_self_collisions_,checker_resolution_);
+    }
+    else
+    {
+      checker_cc_         = std::make_shared<pathplan::ParallelMoveitCollisionChecker>(planning_scn_cc_,        group_name_,parallel_checker_n_threads_,checker_resolution_);
+      checker_replanning_ = std::make_shared<pathplan::ParallelMoveitCollisionChecker>(planning_scn_replanning_,group_name_,parallel_checker_n_threads_,checker_resolution_);
+    }
 
-  checker_cc_         = std::make_shared<pathplan::ParallelMoveitCollisionChecker>(planning_scn_cc_,        group_name_,parallel_checker_n_threads_,checker_resolution_);
-  checker_replanning_ = std::make_shared<pathplan::ParallelMoveitCollisionChecker>(planning_scn_replanning_,group_name_,parallel_checker_n_threads_,checker_resolution_);
+    if(batch_checks_)
+    {
+      batch_checker_cc_         = batchChecker(planning_scn_cc_,        checker_cc_        );
+      batch_checker_replanning_ = batchChecker(planning_scn_replanning_,checker_replanning_);
+    }
+
+    speculative_checkers_.clear();
+    if(speculative_replanning_)
+    {
+      for(unsigned int i=0;i<speculative_offsets_.size();i++)
+        speculative_checkers_.push_back(checker_replanning_->clone());
+    }
+
+    trajectory_ = std::make_shared<pathplan::Trajectory>(nh_,planning_scn_replanning_,group_name_);
+
+    pathplan::TimeParameterizerPtr time_parameterizer = pathplan::TimeParameterizer::fromName(time_parameterization_,totg_path_tolerance_,totg_resample_dt_);
+    if(time_parameterizer)
+      trajectory_->setTimeParameterizer(time_parameterizer);
+    else
+      ROS_ERROR_STREAM("time_parameterization "<<time_parameterization_<<" unknown, set iterative_parabolic");
+
+    if(online_trajectory_generator_)
+    {
+      Eigen::VectorXd max_velocity, max_acceleration;
+      trajectory_->jointLimits(max_velocity,max_acceleration);
+
+      Eigen::VectorXd max_jerk = Eigen::VectorXd::Constant(max_velocity.size(),otg_max_jerk_);
+      trajectory_->setOnlineTrajectoryGenerator(std::make_shared<pathplan::OnlineTrajectoryGenerator>(max_velocity,max_acceleration,max_jerk,0.01,otg_max_deviation_));
+    }
+
+    resources_initialized_ = true;
+  }
+  else
+  {
+    /* The scene may have changed since the previous query: full (not diff) update of all the checkers */
+    if (not planning_scn_cc_->setPlanningSceneMsg(ps_srv.response.scene))
+      throw std::runtime_error("unable to update planning scene");
+
+    checker_cc_        ->setPlanningSceneMsg(planning_scene_msg_);
+    checker_replanning_->setPlanningSceneMsg(planning_scene_msg_);
+    for(const CollisionCheckerPtr& checker:speculative_checkers_)
+      checker->setPlanningSceneMsg(planning_scene_msg_);
+
+    if(batch_checks_)
+    {
+      batch_checker_cc_        ->setPlanningSceneMsg(planning_scene_msg_);
+      batch_checker_replanning_->setPlanningSceneMsg(planning_scene_msg_);
+    }
+  }
+
+  if(static_dynamic_split_)
+    initStaticDynamicSplit(ps_srv.response.scene);
+
+  std::vector<std::string> joint_names = joint_names_;
+
+  current_path_shared_ = current_path_->clone();
 
   current_path_shared_->setChecker(checker_cc_        );
   current_path_       ->setChecker(checker_replanning_);
   solver_             ->setChecker(checker_replanning_);
 
-  trajectory_ = std::make_shared<pathplan::Trajectory>(current_path_shared_,nh_,planning_scn_replanning_,group_name_);
+  trajectory_->setPath(current_path_shared_);
   robot_trajectory::RobotTrajectoryPtr trj = trajectory_->fromPath2Trj();
 
   moveit_msgs::RobotTrajectory tmp_trj_msg   ;
@@ -207,21 +573,578 @@ void ReplannerManagerBase::attributeInitialization()
 
   initReplanner();
   replanner_->setVerbosity(replanner_verbosity_);
+  if(batch_checks_)
+    replanner_->setBatchChecker(batch_checker_replanning_);
 
   obj_ids_.clear();
 
   new_joint_state_.position                 = pnt_.positions                  ;
   new_joint_state_.velocity                 = pnt_.velocities                 ;
   new_joint_state_.name                     = joint_names                     ;
-  new_joint_state_.header.frame_id          = kinematic_model->getModelFrame();
+  new_joint_state_.header.frame_id          = model_frame_                    ;
   new_joint_state_.header.stamp             = ros::Time::now()                ;
   new_joint_state_unscaled_.position        = pnt_unscaled_.positions         ;
   new_joint_state_unscaled_.velocity        = pnt_unscaled_.velocities        ;
   new_joint_state_unscaled_.name            = joint_names                     ;
-  new_joint_state_unscaled_.header.frame_id = kinematic_model->getModelFrame();
+  new_joint_state_unscaled_.header.frame_id = model_frame_                    ;
   new_joint_state_unscaled_.header.stamp    = ros::Time::now()                ;
 }
 
+void ReplannerManagerBase::initStaticDynamicSplit(const moveit_msgs::PlanningScene& scene)
+{
+  static_objects_.clear();
+  dynamic_objects_.clear();
+  for(const moveit_msgs::CollisionObject& obj:scene.world.collision_objects)
+    static_objects_[obj.id] = obj;
+
+  /* The static scene contains the robot and the static objects, the dynamic one only the other objects:
+   * robot-robot collisions are allowed there, so that self collisions are not checked again */
+  planning_scene::PlanningScenePtr static_scn  = planning_scene::PlanningScene::clone(planning_scn_cc_);
+  planning_scene::PlanningScenePtr dynamic_scn = planning_scene::PlanningScene::clone(planning_scn_cc_);
+  dynamic_scn->getWorldNonConst()->clearObjects();
+
+  collision_detection::AllowedCollisionMatrix& acm = dynamic_scn->getAllowedCollisionMatrixNonConst();
+  const std::vector<std::string>& links = dynamic_scn->getRobotModel()->getLinkModelNamesWithCollisionGeometry();
+  for(const std::string& link:links)
+    acm.setEntry(link,links,true);
+
+  if(sdf_checker_)
+  {
+    DistanceFieldPtr static_field  = std::make_shared<pathplan::DistanceField>(*distance_field_);
+    DistanceFieldPtr dynamic_field = std::make_shared<pathplan::DistanceField>(Eigen::Vector3d(sdf_workspace_lb_.data()),Eigen::Vector3d(sdf_workspace_ub_.data()),sdf_resolution_,sdf_truncation_);
+    static_field->setWorldMsg(scene.world,false,static_scn);
+
+    Eigen::Matrix4Xd spheres = Eigen::Map<Eigen::Matrix4Xd>(sdf_spheres_.data(),4,sdf_spheres_.size()/4);
+    checker_static_  = std::make_shared<pathplan::SdfCollisionChecker>(static_scn, group_name_,static_field, sdf_sphere_links_,spheres,sdf_self_collisions_,checker_resolution_);
+    checker_dynamic_ = std::make_shared<pathplan::SdfCollisionChecker>(dynamic_scn,group_name_,dynamic_field,sdf_sphere_links_,spheres,false,               checker_resolution_);
+  }
+  else if(continuous_checker_)
+  {
+    checker_static_  = std::make_shared<pathplan::ContinuousCollisionChecker>(static_scn, group_name_,continuous_self_collisions_,checker_resolution_);
+    checker_dynamic_ = std::make_shared<pathplan::ContinuousCollisionChecker>(dynamic_scn,group_name_,false,                      checker_resolution_);
+  }
+  else
+  {
+    checker_static_  = std::make_shared<pathplan::ParallelMoveitCollisionChecker>(static_scn, group_name_,parallel_checker_n_threads_,checker_resolution_);
+    checker_dynamic_ = std::make_shared<pathplan::ParallelMoveitCollisionChecker>(dynamic_scn,group_name_,parallel_checker_n_threads_,checker_resolution_);
+  }
+
+  if(batch_checks_)
+    batch_checker_static_ = batchChecker(static_scn,checker_static_);
+}
+
+bool ReplannerManagerBase::splitWorld(const moveit_msgs::PlanningSceneWorld& world, moveit_msgs::PlanningScene& dynamic_scene_msg, const bool& octree_changed)
+{
+  /* Fill dynamic_scene_msg with the diff of the dynamic scene. A static object which moves or disappears becomes dynamic
+   * and it is removed from the static scene: return true in that case, because the static validity must be computed again */
+  moveit_msgs::PlanningScene static_scene_msg;
+  static_scene_msg.is_diff  = true;
+  dynamic_scene_msg.is_diff = true;
+  dynamic_scene_msg.world.collision_objects.clear();
+
+  moveit_msgs::CollisionObject remove_obj;
+  remove_obj.operation = moveit_msgs::CollisionObject::REMOVE;
+
+  std::vector<std::string> dynamic_objects;
+  std::map<std::string,moveit_msgs::CollisionObject> static_objects;
+  for(const moveit_msgs::CollisionObject& obj:world.collision_objects)
+  {
+    std::map<std::string,moveit_msgs::CollisionObject>::iterator it = static_objects_.find(obj.id);
+    if(it != static_objects_.end())
+    {
+      /* The shape poses are relative to the object pose, expressed in header.frame_id */
+      if(obj.header.frame_id == it->second.header.frame_id && obj.pose == it->second.pose &&
+         obj.primitives == it->second.primitives && obj.primitive_poses == it->second.primitive_poses &&
+         obj.meshes     == it->second.meshes     && obj.mesh_poses      == it->second.mesh_poses)
+      {
+        static_objects.insert(*it);
+        continue;
+      }
+    }
+
+    dynamic_objects.push_back(obj.id);
+    dynamic_scene_msg.world.collision_objects.push_back(obj);
+    dynamic_scene_msg.world.collision_objects.back().operation = moveit_msgs::CollisionObject::ADD;
+  }
+
+  for(const std::pair<const std::string,moveit_msgs::CollisionObject>& obj:static_objects_)
+  {
+    if(static_objects.find(obj.first) == static_objects.end())
+    {
+      remove_obj.id = obj.first;
+      static_scene_msg.world.collision_objects.push_back(remove_obj);
+    }
+  }
+
+  for(const std::string& id:dynamic_objects_)
+  {
+    if(std::find(dynamic_objects.begin(),dynamic_objects.end(),id) == dynamic_objects.end())
+    {
+      remove_obj.id = id;
+      dynamic_scene_msg.world.collision_objects.push_back(remove_obj);
+    }
+  }
+
+  static_objects_  = static_objects ;
+  dynamic_objects_ = dynamic_objects;
+
+  setWorldMsg(checker_dynamic_,dynamic_scene_msg,octree_changed); //sensor data are dynamic
+
+  if(static_scene_msg.world.collision_objects.empty())
+    return false;
+
+  checker_static_->setPlanningSceneMsg(static_scene_msg);
+  if(batch_checks_)
+    batch_checker_static_->setPlanningSceneMsg(static_scene_msg);
+
+  return true;
+}
+
+std::vector<bool> ReplannerManagerBase::staticValidity(const PathPtr& path)
+{
+  std::vector<bool> static_validity;
+  if(batch_checks_)
+  {
+    for(const int& status:batch_checker_static_->checkConnections(path->getConnections()))
+      static_validity.push_back(status == BatchCollisionChecker::FREE);
+  }
+  else
+  {
+    for(const ConnectionPtr& conn:path->getConnections())
+      static_validity.push_back(checker_static_->checkConnection(conn));
+  }
+
+  return static_validity;
+}
+
+bool ReplannerManagerBase::updateOctree(moveit_msgs::OctomapWithPose& octomap)
+{
+  /* The octomap is moved out of the world message, so that the copies of the world made every cycle stay small.
+   * It is deserialized only when its data or origin changed, and the octree is shared by the checkers (see applyOctree) */
+  moveit_msgs::OctomapWithPose msg;
+  std::swap(msg,octomap);
+
+  if(msg.octomap.data.empty() ||
+     (msg.octomap.data == octomap_msg_.octomap.data && msg.origin == octomap_msg_.origin && msg.header.frame_id == octomap_msg_.header.frame_id))
+    return false;
+
+  std::shared_ptr<octomap::AbstractOcTree> tree(octomap_msgs::msgToMap(msg.octomap));
+  std::shared_ptr<const octomap::OcTree> octree = std::dynamic_pointer_cast<octomap::OcTree>(tree);
+  if(not octree)
+  {
+    ROS_ERROR("the octomap is not an OcTree, ignored");
+    return false;
+  }
+
+  scene_mtx_.lock();
+  octree_ = octree;
+  octomap_msg_ = std::move(msg);
+  octree_version_++;
+  scene_mtx_.unlock();
+
+  return true;
+}
+
+void ReplannerManagerBase::applyOctree(const CollisionCheckerPtr& checker, const bool& octree_changed)
+{
+  if(not octree_)
+    return;
+
+  /* The thread scenes of ParallelMoveitCollisionChecker are private and can be updated only through messages: each of them
+   * deserializes the octomap again, so it is sent only when the octree changed or a world message removed it */
+  if(std::dynamic_pointer_cast<ParallelMoveitCollisionChecker>(checker))
+  {
+    if(octree_changed || not checker->getPlanningScene()->getWorld()->hasObject(planning_scene::PlanningScene::OCTOMAP_NS))
+    {
+      moveit_msgs::PlanningScene msg;
+      msg.is_diff = true;
+      msg.world.octomap = octomap_msg_;
+      checker->setPlanningSceneMsg(msg);
+    }
+    return;
+  }
+
+  /* Cheap when the scene already has this octree at this pose */
+  planning_scene::PlanningScenePtr scene = checker->getPlanningScene();
+  scene->processOctomapPtr(octree_,octreePose(scene));
+}
+
+Eigen::Isometry3d ReplannerManagerBase::octreePose(const planning_scene::PlanningSceneConstPtr& scene)
+{
+  const geometry_msgs::Pose& pose = octomap_msg_.origin;
+  Eigen::Quaterniond q(pose.orientation.w,pose.orientation.x,pose.orientation.y,pose.orientation.z);
+  if(q.norm()<1e-6)
+    q = Eigen::Quaterniond::Identity();
+
+  Eigen::Isometry3d origin = Eigen::Isometry3d::Identity();
+  origin.linear() = q.normalized().toRotationMatrix();
+  origin.translation()<<pose.position.x,pose.position.y,pose.position.z;
+
+  return scene->getFrameTransform(octomap_msg_.header.frame_id)*origin;
+}
+
+void ReplannerManagerBase::applyOctree(const BatchCollisionCheckerPtr& batch_checker, const bool& octree_changed)
+{
+  for(const CollisionCheckerPtr& checker:batch_checker->getCheckers())
+    applyOctree(checker,octree_changed);
+}
+
+void ReplannerManagerBase::setWorldMsg(const CollisionCheckerPtr& checker, const moveit_msgs::PlanningScene& msg, const bool& octree_changed)
+{
+  /* The world messages have no octomap (see updateOctree) and MoveIt removes the octomap of a scene when it processes
+   * a world without it, so the shared octree is applied again after each of them */
+  checker->setPlanningSceneMsg(msg);
+  if(octomap_updates_)
+    applyOctree(checker,octree_changed);
+}
+
+void ReplannerManagerBase::setWorldMsg(const BatchCollisionCheckerPtr& batch_checker, const moveit_msgs::PlanningScene& msg, const bool& octree_changed)
+{
+  batch_checker->setPlanningSceneMsg(msg);
+  if(octomap_updates_)
+    applyOctree(batch_checker,octree_changed);
+}
+
+void ReplannerManagerBase::updateReplanningCheckers(const bool& octree_changed)
+{
+  setWorldMsg(checker_replanning_,planning_scene_diff_msg_,octree_changed);
+  if(batch_checks_)
+    setWorldMsg(batch_checker_replanning_,planning_scene_diff_msg_,octree_changed);
+}
+
+BatchCollisionCheckerPtr ReplannerManagerBase::batchChecker(const planning_scene::PlanningScenePtr& planning_scene, const CollisionCheckerPtr& checker)
+{
+  /* The MoveIt checkers are already parallel: the workers use sequential ones, to not nest thread pools */
+  if(sdf_checker_ || continuous_checker_)
+    return std::make_shared<BatchCollisionChecker>(checker,parallel_checker_n_threads_);
+
+  std::vector<CollisionCheckerPtr> checkers;
+  for(int i=0;i<std::max(parallel_checker_n_threads_,1);i++)
+    checkers.push_back(std::make_shared<pathplan::MoveitCollisionChecker>(planning_scene::PlanningScene::clone(planning_scene),group_name_,checker_resolution_));
+
+  return std::make_shared<BatchCollisionChecker>(checkers);
+}
+
+bool ReplannerManagerBase::checkPathBatch(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx, const BatchCollisionCheckerPtr& batch_checker)
+{
+  /* Same as Path::isValidFromConf, but all the connections from conn_idx are checked at once by the workers of batch_checker */
+  std::vector<ConnectionPtr> conns = path->getConnections();
+
+  std::vector<std::pair<Eigen::VectorXd,Eigen::VectorXd>> segments;
+  for(unsigned int i=conn_idx;i<conns.size();i++)
+  {
+    Eigen::VectorXd parent = (i == (unsigned int) conn_idx)? configuration: conns.at(i)->getParent()->getConfiguration();
+    segments.push_back(std::make_pair(parent,conns.at(i)->getChild()->getConfiguration()));
+  }
+
+  std::vector<int> status = batch_checker->checkPaths(segments);
+
+  bool valid = true;
+  for(unsigned int i=0;i<status.size();i++)
+  {
+    const ConnectionPtr& conn = conns.at(conn_idx+i);
+    if(status.at(i) == BatchCollisionChecker::FREE)
+      conn->setCost(path->getMetrics()->cost(conn->getParent()->getConfiguration(),conn->getChild()->getConfiguration()));
+    else
+    {
+      conn->setCost(std::numeric_limits<double>::infinity());
+      valid = false;
+    }
+  }
+  path->cost();
+
+  return valid;
+}
+
+bool ReplannerManagerBase::checkPathDynamic(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx,
+                                            const CollisionCheckerPtr& checker, const std::vector<bool>& static_validity)
+{
+  /* Check the path from conn_idx (the whole path if negative) against the dynamic objects only,
+   * then restore the infinite cost of the connections made invalid by the static scene */
+  bool valid;
+  if(conn_idx<0)
+    valid = path->isValid(checker);
+  else
+    valid = path->isValidFromConf(configuration,conn_idx,checker);
+
+  std::vector<ConnectionPtr> conns = path->getConnections();
+  for(unsigned int i=std::max(conn_idx,0);i<conns.size() && i<static_validity.size();i++)
+  {
+    if(not static_validity.at(i))
+    {
+      conns.at(i)->setCost(std::numeric_limits<double>::infinity());
+      valid = false;
+    }
+  }
+  path->cost();
+
+  return valid;
+}
+
+bool ReplannerManagerBase::checkConnectionsFromConf(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx, const CollisionCheckerPtr& checker,
+                                                    const std::vector<unsigned int>& conn_ids, const std::vector<bool>& static_validity,
+                                                    const bool& stop_at_obstruction)
+{
+  /* Check only the connections in conn_ids (in that order) from conn_idx (the whole path if negative), the others keep their cost.
+   * The current connection is checked from the configuration, also when it is not in conn_ids but it is still obstructed.
+   * With stop_at_obstruction the check ends at the first obstructed connection, leaving the remaining ones unchecked */
+  std::vector<ConnectionPtr> conns = path->getConnections();
+  unsigned int first = std::max(conn_idx,0);
+
+  std::vector<unsigned int> to_check = conn_ids;
+  if(conn_idx>=0 && conns.at(conn_idx)->getCost() == std::numeric_limits<double>::infinity() &&
+     std::find(to_check.begin(),to_check.end(),(unsigned int) conn_idx) == to_check.end())
+    to_check.push_back(conn_idx);
+
+  for(const unsigned int& idx:to_check)
+  {
+    if(idx<first || idx>=conns.size())
+      continue;
+
+    if(not static_validity.empty() && not static_validity.at(idx)) //invalid whatever the dynamic objects are
+    {
+      conns.at(idx)->setCost(std::numeric_limits<double>::infinity());
+      if(stop_at_obstruction)
+        break;
+
+      continue;
+    }
+
+    const ConnectionPtr& conn = conns.at(idx);
+    bool free;
+    if(conn_idx>=0 && idx == (unsigned int) conn_idx)
+      free = checker->checkPath(configuration,conn->getChild()->getConfiguration());
+    else
+      free = checker->checkConnection(conn);
+
+    if(free)
+      conn->setCost(path->getMetrics()->cost(conn->getParent()->getConfiguration(),conn->getChild()->getConfiguration()));
+    else
+    {
+      conn->setCost(std::numeric_limits<double>::infinity());
+      if(stop_at_obstruction)
+        break;
+    }
+  }
+  path->cost();
+
+  for(unsigned int i=first;i<conns.size();i++)
+  {
+    if(conns.at(i)->getCost() == std::numeric_limits<double>::infinity())
+      return false;
+  }
+
+  return true;
+}
+
+std::vector<double> ReplannerManagerBase::connectionTimes(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx, const double& time_to_end)
+{
+  /* Time to reach the start of each connection (and the end of the path as last element) from the configuration,
+   * assuming a constant speed along the remaining path. The connections before conn_idx get zero */
+  std::vector<ConnectionPtr> conns = path->getConnections();
+  std::vector<double> times(conns.size()+1,0.0);
+
+  double length = 0.0;
+  for(unsigned int i=std::max(conn_idx,0);i<conns.size();i++)
+  {
+    times.at(i) = length;
+    length += (i == (unsigned int) conn_idx)? (conns.at(i)->getChild()->getConfiguration()-configuration).norm(): conns.at(i)->norm();
+  }
+  times.back() = length;
+
+  for(double& t:times)
+    t = (length>0.0)? time_to_end*t/length: 0.0;
+
+  return times;
+}
+
+void ReplannerManagerBase::updatePredictedCheckers(const ObstaclePredictorPtr& predictor, const moveit_msgs::PlanningSceneWorld& world,
+                                                   std::vector<CollisionCheckerPtr>& checkers, const bool& octree_changed)
+{
+  /* One checker for each time band of the prediction, with the moving objects swept over that band */
+  while(checkers.size()<predictor->bands())
+    checkers.push_back(checker_cc_->clone());
+
+  moveit_msgs::PlanningScene predicted_scene_msg;
+  predicted_scene_msg.is_diff = true;
+  for(unsigned int b=0;b<checkers.size();b++)
+  {
+    predicted_scene_msg.world = predictor->predict(world,b*predictor->getStep(),(b+1)*predictor->getStep());
+    setWorldMsg(checkers.at(b),predicted_scene_msg,octree_changed);
+  }
+}
+
+bool ReplannerManagerBase::checkPathPredicted(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx,
+                                              const std::vector<double>& times, const ObstaclePredictorPtr& predictor,
+                                              const std::vector<CollisionCheckerPtr>& checkers)
+{
+  /* Each connection from conn_idx (the whole path if negative) is checked against the objects predicted
+   * in all the time bands overlapping the interval in which the robot traverses it */
+  std::vector<ConnectionPtr> conns = path->getConnections();
+  bool valid = true;
+
+  for(unsigned int i=std::max(conn_idx,0);i<conns.size();i++)
+  {
+    const ConnectionPtr& conn = conns.at(i);
+    Eigen::VectorXd parent = (conn_idx>=0 && i == (unsigned int) conn_idx)? configuration: conn->getParent()->getConfiguration();
+
+    bool free = true;
+    for(unsigned int b=predictor->band(times.at(i));b<=predictor->band(times.at(i+1)) && free;b++)
+      free = checkers.at(b)->checkPath(parent,conn->getChild()->getConfiguration());
+
+    if(free)
+      conn->setCost(path->getMetrics()->cost(conn->getParent()->getConfiguration(),conn->getChild()->getConfiguration()));
+    else
+    {
+      conn->setCost(std::numeric_limits<double>::infinity());
+      valid = false;
+    }
+  }
+  path->cost();
+
+  return valid;
+}
+
+std::vector<unsigned int> ReplannerManagerBase::scheduleConnections(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx,
+                                                                  const std::vector<unsigned int>& conn_ids, const double& time_to_end,
+                                                                  const unsigned long& cycle, std::vector<bool>& pending)
+{
+  /* The connections in conn_ids become pending and are checked when due: the ones reached within check_horizon_ seconds
+   * every cycle, the ones reached between k and k+1 horizons every 2^k cycles (at most check_max_period_) */
+  std::vector<ConnectionPtr> conns = path->getConnections();
+  if(pending.size() != conns.size())
+    pending.assign(conns.size(),true);
+
+  for(const unsigned int& idx:conn_ids)
+  {
+    if(idx<conns.size())
+      pending.at(idx) = true;
+  }
+
+  std::vector<double> times = connectionTimes(path,configuration,conn_idx,time_to_end);
+
+  std::vector<unsigned int> due_ids;
+  for(unsigned int i=conn_idx;i<conns.size();i++)
+  {
+    if(not pending.at(i))
+      continue;
+
+    int band = std::min(std::floor(times.at(i)/check_horizon_),30.0);
+    unsigned long period = std::min(1UL<<band,(unsigned long) check_max_period_);
+
+    if(cycle%period == 0)
+    {
+      due_ids.push_back(i);
+      pending.at(i) = false;
+    }
+  }
+
+  return due_ids;
+}
+
+std::vector<Eigen::AlignedBox3d> ReplannerManagerBase::changedRegions(const moveit_msgs::PlanningSceneWorld& world, std::map<std::string,moveit_msgs::CollisionObject>& world_objects,
+                                                                     const bool& octree_changed, Eigen::AlignedBox3d& octree_region)
+{
+  /* The boxes are in the planning frame of the collision checking scene. The octomap is not in the world messages
+   * (see updateOctree): when the octree changes, the space known by the old and by the new one has changed */
+  std::vector<Eigen::AlignedBox3d> regions = SweptVolumeGrid::changedRegions(world,world_objects,checker_cc_->getPlanningScene());
+
+  if(octree_changed && octree_)
+  {
+    if(not octree_region.isEmpty())
+      regions.push_back(octree_region);
+
+    octree_region = SweptVolumeGrid::octreeBox(*octree_,octreePose(checker_cc_->getPlanningScene()));
+    regions.push_back(octree_region);
+  }
+
+  return regions;
+}
+
+std::vector<unsigned int> ReplannerManagerBase::prioritizeConnections(const PathPtr& path, const SweptVolumeGridPtr& swept_volumes, const std::vector<unsigned int>& conn_ids,
+                                                                    const std::vector<Eigen::AlignedBox3d>& changed_regions,
+                                                                    const std::map<std::string,moveit_msgs::CollisionObject>& world_objects)
+{
+  /* The connections most likely to be obstructed are checked first: the ones already obstructed, then the ones nearest
+   * to the objects changed in this cycle and, among them, the ones nearest to the objects which can move (all of them without the static/dynamic split) */
+  std::vector<Eigen::AlignedBox3d> object_boxes;
+  for(const std::pair<const std::string,moveit_msgs::CollisionObject>& obj:world_objects)
+  {
+    if(static_dynamic_split_ && static_objects_.find(obj.first) != static_objects_.end())
+      continue;
+
+    object_boxes.push_back(SweptVolumeGrid::objectBox(obj.second,checker_cc_->getPlanningScene()));
+  }
+
+  std::vector<ConnectionPtr> conns = path->getConnections();
+  std::vector<std::tuple<bool,double,double,unsigned int>> priorities;
+  for(const unsigned int& idx:conn_ids)
+  {
+    if(idx>=conns.size())
+      continue;
+
+    priorities.push_back(std::make_tuple(conns.at(idx)->getCost() != std::numeric_limits<double>::infinity(),
+                                         swept_volumes->distance(idx,changed_regions),
+                                         swept_volumes->distance(idx,object_boxes),idx));
+  }
+  std::sort(priorities.begin(),priorities.end());
+
+  std::vector<unsigned int> ordered_ids;
+  for(const std::tuple<bool,double,double,unsigned int>& p:priorities)
+    ordered_ids.push_back(std::get<3>(p));
+
+  return ordered_ids;
+}
+
+void ReplannerManagerBase::checkCurrentPath(const PathPtr& path, const Eigen::VectorXd& configuration, const int& conn_idx, const double& time_to_end,
+                                            const ObstaclePredictorPtr& predictor, const std::vector<CollisionCheckerPtr>& predicted_checkers,
+                                            const SweptVolumeGridPtr& swept_volumes, const std::vector<Eigen::AlignedBox3d>& changed_regions,
+                                            const std::map<std::string,moveit_msgs::CollisionObject>& world_objects, const std::vector<bool>& static_validity,
+                                            unsigned long& cycle, std::vector<bool>& pending, bool& full_check)
+{
+  /* Check of the current path from configuration in the mode set by the parameters, shared by the collision check threads.
+   * full_check is true if the next cycle must check the whole path, instead of the connections near the changed objects only */
+  if(obstacle_prediction_)
+    checkPathPredicted(path,configuration,conn_idx,connectionTimes(path,configuration,conn_idx,time_to_end),predictor,predicted_checkers);
+  else if(prioritized_path_checks_ || check_horizon_>0.0)
+  {
+    std::vector<unsigned int> conn_ids;
+    if(swept_volume_invalidation_ && not full_check)
+      conn_ids = swept_volumes->connectionsInRegions(changed_regions);
+    else
+    {
+      for(unsigned int i=conn_idx;i<path->getConnectionsSize();i++)
+        conn_ids.push_back(i);
+    }
+
+    if(check_horizon_>0.0)
+      conn_ids = scheduleConnections(path,configuration,conn_idx,conn_ids,time_to_end,cycle++,pending);
+
+    if(prioritized_path_checks_)
+      conn_ids = prioritizeConnections(path,swept_volumes,conn_ids,changed_regions,world_objects);
+
+    bool valid = checkConnectionsFromConf(path,configuration,conn_idx,static_dynamic_split_? checker_dynamic_: checker_cc_,
+                                          conn_ids,static_validity,prioritized_path_checks_);
+
+    // The connections skipped after an obstruction are checked in the next cycle
+    full_check = prioritized_path_checks_ && not valid;
+  }
+  else
+  {
+    if(swept_volume_invalidation_ && not full_check)
+      checkConnectionsFromConf(path,configuration,conn_idx,static_dynamic_split_? checker_dynamic_: checker_cc_,
+                               swept_volumes->connectionsInRegions(changed_regions),static_validity);
+    else if(static_dynamic_split_)
+      checkPathDynamic(path,configuration,conn_idx,checker_dynamic_,static_validity);
+    else if(batch_checks_)
+      checkPathBatch(path,configuration,conn_idx,batch_checker_cc_);
+    else
+      path->isValidFromConf(configuration,conn_idx,checker_cc_);
+
+    full_check = false;
+  }
+}
+
 void ReplannerManagerBase::overrideCallback(const std_msgs::Int64ConstPtr& msg, const std::string& override_name)
 {
   double ovr;
@@ -254,9 +1177,18 @@ void ReplannerManagerBase::subscribeTopicsAndServices()
     overrides_.insert(std::pair<std::string,double>(scaling_topic_name,0.0));
     ROS_BOLDWHITE_STREAM("Subscribing speed override topic "<<scaling_topic_name.c_str());
   }
-
-  target_pub_          = nh_.advertise<sensor_msgs::JointState>(joint_target_topic_,         10);
-  unscaled_target_pub_ = nh_.advertise<sensor_msgs::JointState>(unscaled_joint_target_topic_,10);
+
+  /* With setpoint streaming the controller gets only the chunks, not the joint targets */
+  if(setpoint_streaming_)
+  {
+    chunk_pub_          = nh_.advertise<trajectory_msgs::JointTrajectory>(chunk_topic_,         10);
+    unscaled_chunk_pub_ = nh_.advertise<trajectory_msgs::JointTrajectory>(unscaled_chunk_topic_,10);
+  }
+  else
+  {
+    target_pub_          = nh_.advertise<sensor_msgs::JointState>(joint_target_topic_,         10);
+    unscaled_target_pub_ = nh_.advertise<sensor_msgs::JointState>(unscaled_joint_target_topic_,10);
+  }
 
   if(benchmark_)
     text_overlay_pub_ = nh_.advertise<jsk_rviz_plugins::OverlayText>("/rviz_text_overlay_replanner_bench",1);
@@ -338,6 +1270,8 @@ bool ReplannerManagerBase::uploadPathCost(const PathPtr& current_path_updated_co
   paths_mtx_.lock();
   if(not current_path_sync_needed_)
   {
+    double cost_before_update = current_path_shared_->getCostFromConf(current_configuration_);
+
     std::vector<ConnectionPtr> current_path_conns      = current_path_shared_     ->getConnections();
     std::vector<ConnectionPtr> current_path_copy_conns = current_path_updated_copy->getConnections();
     for(unsigned int z=0;z<current_path_conns.size();z++)
@@ -350,6 +1284,9 @@ bool ReplannerManagerBase::uploadPathCost(const PathPtr& current_path_updated_co
     }
     current_path_shared_->cost();
 
+    if(current_path_shared_->getCostFromConf(current_configuration_)>cost_before_update)
+      path_cost_increased_ = true;
+
   }
   else
     updated = false;
@@ -386,10 +1323,16 @@ bool ReplannerManagerBase::updateTrajectory()
            return true;
          }());
 
-  trj_path->resample(max_distance/5.0);
+  if(adaptive_resampling_)
+    trj_path = adaptiveResample(trj_path,max_distance/5.0);
+  else
+    trj_path->resample(max_distance/5.0);
 
   trajectory_->setPath(trj_path);
   robot_trajectory::RobotTrajectoryPtr trj= trajectory_->fromPath2Trj(pnt_);
+  if(not trj)
+    return false;
+
   moveit_msgs::RobotTrajectory tmp_trj_msg;
   trj->getRobotTrajectoryMsg(tmp_trj_msg);
 
@@ -414,7 +1357,11 @@ void ReplannerManagerBase::replanningThread()
   bool success = false;
   bool path_changed = false;
   bool path_obstructed = true;
+  unsigned int replanning_octree_version = 0;
+  bool path_improved = false;
+  bool replanning_demanded = true;
   double replanning_duration = 0.0;
+  double cost_before_replanning;
   double duration, abscissa_current_configuration, abscissa_replan_configuration;
 
   Eigen::VectorXd projection = configuration_replan_;
@@ -460,7 +1407,10 @@ void ReplannerManagerBase::replanningThread()
       replanner_mtx_.unlock();
 
       scene_mtx_.lock();
-      checker_replanning_->setPlanningSceneMsg(planning_scene_diff_msg_);
+      bool octree_changed = (replanning_octree_version != octree_version_);
+      replanning_octree_version = octree_version_;
+
+      updateReplanningCheckers(octree_changed);
       downloadPathCost();
       planning_scene_msg_benchmark_ = planning_scene_msg_;
       scene_mtx_.unlock();
@@ -478,29 +1428,53 @@ void ReplannerManagerBase::replanningThread()
       replanner_->setChecker(checker_replanning_);
       replanner_->setCurrentConf(configuration_replan_);
 
-      path_obstructed = (current_path_->getCostFromConf(configuration_replan_) == std::numeric_limits<double>::infinity());
+      cost_before_replanning = current_path_->getCostFromConf(configuration_replan_);
+      path_obstructed = (cost_before_replanning == std::numeric_limits<double>::infinity());
       replanner_mtx_.unlock();
 
       success = false;
       path_changed = false;
       replanning_duration = 0.0;
 
-      if(haveToReplan(path_obstructed))
+      if(demand_driven_replanning_)
+        replanning_demanded = replanningDemanded(path_obstructed);
+
+      if(replanning_demanded && haveToReplan(path_obstructed))
       {
         n_size_before = current_path_->getConnectionsSize();
 
         tic_rep=ros::WallTime::now();
-        path_changed = replan();      //path may have changed even though replanning was unsuccessful
+        if(speculative_replanning_)
+          path_changed = speculativeReplan(success);
+        else
+        {
+          path_changed = replan();      //path may have changed even though replanning was unsuccessful
+          success = replanner_->getSuccess();
+        }
         toc_rep=ros::WallTime::now();
 
         replanning_duration = (toc_rep-tic_rep).toSec();
-        success = replanner_->getSuccess();
 
         bench_mtx_.lock();
         if(success)
           replanning_time_ = replanning_duration;
         bench_mtx_.unlock();
 
+        if(demand_driven_replanning_)
+        {
+          path_improved = success && (replanner_->getReplannedPath()->cost()<cost_before_replanning);
+          updateReplanningScheduler(path_improved);
+        }
+
+        if(adaptive_time_shift_)
+        {
+          addReplanningLatency(replanning_duration);
+
+          trj_mtx_.lock();
+          time_shift_ = computeTimeShift(); //t_replan_ is updated by the trajectory execution thread
+          trj_mtx_.unlock();
+        }
+
         assert(((not path_changed) && (n_size_before == current_path_->getConnectionsSize())) || (path_changed));
       }
 
@@ -523,11 +1497,15 @@ void ReplannerManagerBase::replanningThread()
 
         tic_trj_ = ros::WallTime::now();
 
+        double trajectory_time = 0.0;
         if(success)
         {
+          /* The online generator falls back to the time parameterization when it cannot splice the state onto the
+           * new path, so the robot always follows the path published below */
           trajectory_->setPath(trj_path);
 
           robot_trajectory::RobotTrajectoryPtr trj= trajectory_->fromPath2Trj(pnt_);
+          trajectory_time = trajectory_->getParameterizationTime();
 
           moveit_msgs::RobotTrajectory tmp_trj_msg;
           trj->getRobotTrajectoryMsg(tmp_trj_msg);
@@ -550,6 +1528,11 @@ void ReplannerManagerBase::replanningThread()
 
         trj_mtx_.unlock();
         replanner_mtx_.unlock();
+
+        bench_mtx_.lock();
+        if(success)
+          trajectory_time_ = trajectory_time;
+        bench_mtx_.unlock();
       }
 
       toc=ros::WallTime::now();
@@ -560,6 +1543,8 @@ void ReplannerManagerBase::replanningThread()
         ROS_BOLDYELLOW_STREAM("Replanning thread time expired: duration-> "<<duration);
         ROS_BOLDYELLOW_STREAM("replanning time-> "<<replanning_duration);
       }
+
+      replanningIdleTime(lp.expectedCycleTime().toSec()-(ros::WallTime::now()-tic).toSec());
     }
 
     lp.sleep();
@@ -576,11 +1561,45 @@ void ReplannerManagerBase::collisionCheckThread()
   PathPtr current_path_copy = current_path_shared_->clone();
   current_path_copy->setChecker(checker_cc_);
 
+  Eigen::VectorXd goal_conf = replanner_->getGoal()->getConfiguration();
+
   double duration;
   ros::WallTime tic,toc;
   ros::WallRate lp(collision_checker_thread_frequency_);
 
   moveit_msgs::PlanningScene planning_scene_msg;
+  moveit_msgs::PlanningScene dynamic_scene_msg;
+
+  std::vector<bool> static_validity;
+  bool static_validity_outdated = true;
+
+  /* With swept volume invalidation only the connections near the objects changed since the last check are checked again,
+   * with prioritized checks the connections nearest to the objects are checked first and the check stops at the first obstruction */
+  bool use_swept_volumes = swept_volume_invalidation_ || prioritized_path_checks_;
+  SweptVolumeGridPtr swept_volumes;
+  if(use_swept_volumes)
+  {
+    swept_volumes = std::make_shared<SweptVolumeGrid>(planning_scn_cc_->getRobotModel(),group_name_,swept_volume_cell_size_,checker_resolution_,swept_volume_margin_);
+    swept_volumes->setPath(current_path_copy);
+  }
+
+  /* With the obstacle prediction the path is checked against the positions of the moving objects when the robot will traverse it */
+  ObstaclePredictorPtr predictor;
+  std::vector<CollisionCheckerPtr> predicted_checkers;
+  if(obstacle_prediction_)
+    predictor = std::make_shared<ObstaclePredictor>(prediction_horizon_,prediction_step_);
+
+  /* With a check horizon the connections reached soon are checked every cycle, the later ones less often */
+  double time_to_end = 0.0;
+  unsigned long cycle = 0;
+  std::vector<bool> pending;
+
+  bool full_check = true;
+  std::vector<Eigen::AlignedBox3d> changed_regions;
+  std::map<std::string,moveit_msgs::CollisionObject> world_objects;
+  std::vector<moveit_msgs::AttachedCollisionObject> attached_objects;
+  Eigen::AlignedBox3d octree_region;
+  octree_region.setEmpty();
 
   while ((not stop_) && ros::ok())
   {
@@ -588,6 +1607,8 @@ void ReplannerManagerBase::collisionCheckThread()
 
     /* Update planning scene */
     ps_srv.request.components.components = 20;//moveit_msgs::PlanningSceneComponents::WORLD_OBJECT_GEOMETRY + moveit_msgs::PlanningSceneComponents::ROBOT_STATE_ATTACHED_OBJECTS
+    if(octomap_updates_)
+      ps_srv.request.components.components += moveit_msgs::PlanningSceneComponents::OCTOMAP;
 
     if(not plannning_scene_client_.call(ps_srv))
     {
@@ -596,27 +1617,74 @@ void ReplannerManagerBase::collisionCheckThread()
       break;
     }
 
+    bool octree_changed = octomap_updates_ && updateOctree(ps_srv.response.scene.world.octomap);
+
     scene_mtx_.lock();
+    if(octree_changed || planning_scene_msg.world != ps_srv.response.scene.world)
+      world_version_++;
+
     planning_scene_msg.world = ps_srv.response.scene.world;
     planning_scene_msg.is_diff = true;
-    checker_cc_->setPlanningSceneMsg(planning_scene_msg);
+    setWorldMsg(checker_cc_,planning_scene_msg,octree_changed);
+    if(batch_checks_)
+      setWorldMsg(batch_checker_cc_,planning_scene_msg,octree_changed);
+
+    if(static_dynamic_split_ && splitWorld(ps_srv.response.scene.world,dynamic_scene_msg,octree_changed))
+      static_validity_outdated = true;
     scene_mtx_.unlock();
 
+    if(obstacle_prediction_) //the octree is written only by this thread
+    {
+      predictor->update(ps_srv.response.scene.world,tic.toSec());
+      updatePredictedCheckers(predictor,ps_srv.response.scene.world,predicted_checkers,octree_changed);
+    }
+
+    if(octree_changed) //the sensor data can have changed anywhere
+      full_check = true;
+
+    if(use_swept_volumes)
+    {
+      changed_regions = changedRegions(ps_srv.response.scene.world,world_objects,octree_changed,octree_region);
+      if(attached_objects != ps_srv.response.scene.robot_state.attached_collision_objects) //the robot itself has changed
+      {
+        attached_objects = ps_srv.response.scene.robot_state.attached_collision_objects;
+        full_check = true;
+      }
+    }
+
     trj_mtx_.lock();
 
     current_configuration_copy = current_configuration_;
+    if(check_horizon_>0.0 || obstacle_prediction_)
+      time_to_end = std::max(trajectory_->getTrj()->getDuration()-t_,0.0)/std::max(scaling_,1.0e-3);
 
     paths_mtx_.lock();
+    bool path_changed = current_path_sync_needed_;
     if(current_path_sync_needed_)
     {
       current_path_copy = current_path_shared_->clone();
       current_path_copy->setChecker(checker_cc_);
       current_path_sync_needed_ = false;
+      static_validity_outdated = true;
     }
     paths_mtx_.unlock();
     trj_mtx_.unlock();
 
-    if((current_configuration_copy-replanner_->getGoal()->getConfiguration()).norm()<goal_tol_)
+    /* The static validity of the connections is computed only when the path or the static scene change */
+    if(static_dynamic_split_ && static_validity_outdated)
+    {
+      static_validity = staticValidity(current_path_copy);
+      static_validity_outdated = false;
+      full_check = true;
+    }
+
+    if(use_swept_volumes && path_changed)
+    {
+      swept_volumes->setPath(current_path_copy);
+      full_check = true;
+    }
+
+    if((current_configuration_copy-goal_conf).norm()<goal_tol_)
     {
       stop_ = true;
       break;
@@ -625,15 +1693,21 @@ void ReplannerManagerBase::collisionCheckThread()
     int conn_idx;
     current_path_copy->findConnection(current_configuration_copy,conn_idx);
     if(conn_idx<0)
+    {
+      full_check = true; //the changes of this cycle have not been checked
       continue;
+    }
     else
-      current_path_copy->isValidFromConf(current_configuration_copy,conn_idx,checker_cc_);
+      checkCurrentPath(current_path_copy,current_configuration_copy,conn_idx,time_to_end,predictor,predicted_checkers,
+                       swept_volumes,changed_regions,world_objects,static_validity,cycle,pending,full_check);
 
     scene_mtx_.lock();
     if(uploadPathCost(current_path_copy)) //if path cost can be updated, update also the planning scene used to check the path
     {
       planning_scene_msg_.world = ps_srv.response.scene.world;  //not diff,it contains all pln scn info but only world is updated
       planning_scene_diff_msg_ = planning_scene_msg;            //diff, contains only world
+      if(obstacle_prediction_) //the replanner avoids the positions the moving objects will occupy within the prediction horizon
+        planning_scene_diff_msg_.world = predictor->predict(ps_srv.response.scene.world,0.0,prediction_horizon_);
 
       download_scene_info_ = true;      //dowloadPathCost can be called because the scene and path cost are referred now to the last path found
     }
@@ -653,17 +1727,303 @@ void ReplannerManagerBase::collisionCheckThread()
 
 bool ReplannerManagerBase::replan()
 {
+  if(adaptive_time_shift_)
+    replanner_->setMaxTime(0.9*adaptiveDtReplan(dt_replan_));
+
   return replanner_->replan();
 }
 
+bool ReplannerManagerBase::replanningDemanded(const bool path_obstructed)
+{
+  /* Replanning is triggered by an obstructed path, by a change of the world or by
+   * an increase of the current path cost detected by the collision check thread.
+   * Otherwise, a replanning to improve the path is allowed once per improvement period */
+  bool demanded = path_obstructed;
+
+  scene_mtx_.lock();
+  if(world_version_ != last_world_version_)
+  {
+    last_world_version_ = world_version_;
+    demanded = true;
+  }
+  scene_mtx_.unlock();
+
+  paths_mtx_.lock();
+  if(path_cost_increased_)
+  {
+    path_cost_increased_ = false;
+    demanded = true;
+  }
+  paths_mtx_.unlock();
+
+  if(demanded)
+    improvement_period_ = min_improvement_period_;
+  else if((ros::WallTime::now()-last_replanning_time_).toSec()>=improvement_period_)
+    demanded = true;
+
+  return demanded;
+}
+
+void ReplannerManagerBase::updateReplanningScheduler(const bool path_improved)
+{
+  /* Back off when replanning does not improve the path */
+  last_replanning_time_ = ros::WallTime::now();
+
+  if(path_improved)
+    improvement_period_ = min_improvement_period_;
+  else
+    improvement_period_ = std::min(2.0*improvement_period_,max_improvement_period_);
+}
+
+bool ReplannerManagerBase::speculativeReplan(bool& success)
+{
+  /* Replan concurrently from several configurations ahead on the current path (one for each
+   * lookahead offset, expressed as a multiple of the time shift), each one on its own copy
+   * of the current path and of the collision checker. Among the successful replanners whose
+   * start configuration is still ahead of the robot when they finish, the one with the
+   * shortest lookahead is adopted as replanner */
+
+  std::vector<Eigen::VectorXd> points2project;
+  trajectory_msgs::JointTrajectoryPoint pnt;
+  Eigen::VectorXd point2project(pnt_replan_.positions.size());
+
+  trj_mtx_.lock();
+  for(const double& offset:speculative_offsets_)
+  {
+    interpolator_.interpolate(ros::Duration(t_+offset*time_shift_*scaling_),pnt,scaling_);
+    for(unsigned int i=0; i<pnt.positions.size();i++)
+      point2project(i) = pnt.positions.at(i);
+
+    points2project.push_back(point2project);
+  }
+  trj_mtx_.unlock();
+
+  scene_mtx_.lock();
+  bool octree_changed = (speculative_octree_version_ != octree_version_);
+  speculative_octree_version_ = octree_version_;
+
+  for(const CollisionCheckerPtr& checker:speculative_checkers_)
+    setWorldMsg(checker,planning_scene_diff_msg_,octree_changed);
+  scene_mtx_.unlock();
+
+  double max_time = 0.9*adaptiveDtReplan(dt_replan_);
+  std::vector<ReplannerBasePtr> replanners;
+
+  replanner_mtx_.lock();
+  for(unsigned int i=0;i<points2project.size();i++)
+  {
+    PathPtr path = ReplannerBase::clonePathWithTree(current_path_,speculative_checkers_.at(i),solver_->getMaxDistance());
+    if(not path)
+      continue;
+
+    Eigen::VectorXd configuration = path->projectOnPath(points2project.at(i),configuration_replan_,false);
+    if(not path->findConnection(configuration))
+      continue;
+
+    ReplannerBasePtr replanner = speculativeReplanner(configuration,path);
+    if(not replanner)
+      continue;
+
+    // The solver copy grows the tree copy, not the tree of the current path
+    if(replanner->getSolver()->getStartTree() == current_path_->getTree())
+      replanner->getSolver()->setStartTree(path->getTree());
+
+    replanner->setMaxTime(max_time);
+    replanner->setVerbosity(replanner_verbosity_);
+    replanners.push_back(replanner);
+  }
+  replanner_mtx_.unlock();
+
+  std::vector<std::shared_future<bool>> tasks;
+  for(const ReplannerBasePtr& replanner:replanners)
+    tasks.push_back(std::async(std::launch::async,&ReplannerBase::replan,replanner));
+
+  for(unsigned int i=0; i<tasks.size();i++)
+    tasks.at(i).wait();
+
+  trj_mtx_.lock();
+  Eigen::VectorXd current_configuration = current_configuration_;
+  trj_mtx_.unlock();
+
+  ReplannerBasePtr adopted_replanner = nullptr;
+
+  replanner_mtx_.lock();
+  double abscissa_current_configuration = current_path_->curvilinearAbscissaOfPoint(current_configuration);
+  for(const ReplannerBasePtr& replanner:replanners)
+  {
+    if(not replanner->getSuccess())
+      continue;
+
+    if(current_path_->curvilinearAbscissaOfPoint(replanner->getCurrentConf())>abscissa_current_configuration)
+    {
+      adopted_replanner = replanner;
+      break;
+    }
+  }
+
+  if(adopted_replanner)
+  {
+    replanner_ = adopted_replanner;
+    configuration_replan_ = replanner_->getCurrentConf();
+  }
+  replanner_mtx_.unlock();
+
+  /* Without an adopted replanner, replanner_ has not replanned in this cycle */
+  success = (adopted_replanner != nullptr);
+  return success;
+}
+
+void ReplannerManagerBase::replanningIdleTime(const double& available_time)
+{
+}
+
+ReplannerBasePtr ReplannerManagerBase::speculativeReplanner(Eigen::VectorXd& configuration, PathPtr& path)
+{
+  return nullptr;
+}
+
+TreeSolverPtr ReplannerManagerBase::cloneSolver(const CollisionCheckerPtr& checker)
+{
+  return cloneSolver(solver_,checker);
+}
+
+TreeSolverPtr ReplannerManagerBase::cloneSolver(const TreeSolverPtr& solver, const CollisionCheckerPtr& checker)
+{
+  SamplerPtr sampler = std::make_shared<InformedSampler>(solver->getSampler()->getLB(),solver->getSampler()->getUB(),
+                                                         solver->getSampler()->getLB(),solver->getSampler()->getUB());
+  MetricsPtr metrics = solver->getMetrics()->clone();
+
+  TreeSolverPtr cloned_solver = solver->clone(metrics,checker,sampler);
+  cloned_solver->importFromSolver(solver);
+
+  return cloned_solver;
+}
+
+double ReplannerManagerBase::computeTimeShift()
+{
+  return adaptiveDtReplan(dt_replan_)*K_OFFSET;
+}
+
+void ReplannerManagerBase::addReplanningLatency(const double& replanning_duration)
+{
+  replanning_latencies_.push_back(replanning_duration);
+  while(replanning_latencies_.size()>(unsigned int) latency_window_size_)
+    replanning_latencies_.pop_front();
+}
+
+double ReplannerManagerBase::replanningLatency()
+{
+  if(replanning_latencies_.empty())
+    return std::numeric_limits<double>::infinity();
+
+  std::vector<double> latencies(replanning_latencies_.begin(),replanning_latencies_.end());
+  unsigned int idx = std::ceil(latency_percentile_*latencies.size())-1;
+  idx = std::min(idx,(unsigned int) (latencies.size()-1));
+
+  std::nth_element(latencies.begin(),latencies.begin()+idx,latencies.end());
+  return latencies.at(idx);
+}
+
+double ReplannerManagerBase::adaptiveDtReplan(const double& dt_replan_max)
+{
+  /* Without measures (or when the adaptive mode is disabled) the nominal replanning time is used.
+   * Otherwise, the replanning time is the percentile of the measured latencies increased by a margin:
+   * replannings which exhaust their time budget (0.9 of the estimate) make the estimate grow again towards dt_replan_max,
+   * since latency_margin > 1/0.9 */
+  if((not adaptive_time_shift_) || replanning_latencies_.empty())
+    return dt_replan_max;
+
+  return std::min(std::max(latency_margin_*replanningLatency(),dt_replan_min_),dt_replan_max);
+}
+
+bool ReplannerManagerBase::reset(const PathPtr& current_path, const Eigen::VectorXd& goal_conf)
+{
+  /* Prepare the manager for a new query keeping parameters, subscriptions, planning scenes and checkers.
+   * The query-specific attributes are initialized again by run() */
+  if((current_path->getGoalNode()->getConfiguration()-goal_conf).norm()>TOLERANCE)
+  {
+    ROS_ERROR("the path does not end at the goal");
+    return false;
+  }
+
+  stop(); //the threads stay alive
+
+  current_path_ = current_path;
+  solver_->getSampler()->setCost(std::numeric_limits<double>::infinity());  //remove the informed bound of the previous query
+
+  return true;
+}
+
+void ReplannerManagerBase::serveQueries(const std::function<void()>& body, const double& delay, const unsigned int& last_query)
+{
+  unsigned int query = last_query;
+  while(true)
+  {
+    std::unique_lock<std::mutex> lock(query_mtx_);
+    query_cv_.wait(lock,[&](){return shutdown_ || query_id_ != query;});
+    if(shutdown_)
+      return;
+
+    query = query_id_;
+    lock.unlock();
+
+    if(delay>0.0)
+      ros::Duration(delay).sleep();
+
+    body();
+
+    lock.lock();
+    running_threads_--;
+    lock.unlock();
+    query_cv_.notify_all();
+  }
+}
+
+void ReplannerManagerBase::launchThread(std::thread& thread, const std::function<void()>& body, const double& delay)
+{
+  if(thread.joinable())
+    return;
+
+  std::lock_guard<std::mutex> lock(query_mtx_);
+  thread = std::thread(&ReplannerManagerBase::serveQueries,this,body,delay,query_id_);
+  n_threads_++;
+}
+
+void ReplannerManagerBase::launchThreads()
+{
+  /* The features disabled in a query leave their thread idle for that query */
+  launchThread(display_thread_   ,[this](){displayThread();});
+  launchThread(col_check_thread_ ,[this](){collisionCheckThread();});
+  if(spawn_objs_)
+    launchThread(spawn_obj_thread_ ,[this](){if(spawn_objs_) spawnObjectsThread();});
+  if(benchmark_)
+    launchThread(benchmark_thread_ ,[this](){if(benchmark_) benchmarkThread();});
+  if(replanning_enabled_)
+    launchThread(replanning_thread_,[this](){if(replanning_enabled_) replanningThread();});
+  launchThread(trj_exec_thread_  ,[this](){trajectoryExecutionThread();},0.1); //after the other ones have started
+}
+
+void ReplannerManagerBase::shutdownThreads()
+{
+  stop_ = true;
+  joinThreads();
+
+  query_mtx_.lock();
+  shutdown_ = true;
+  query_mtx_.unlock();
+  query_cv_.notify_all();
+
+  for(std::thread* thread:{&display_thread_,&col_check_thread_,&spawn_obj_thread_,&benchmark_thread_,&replanning_thread_,&trj_exec_thread_})
+  {
+    if(thread->joinable())
+      thread->join();
+  }
+}
+
 bool ReplannerManagerBase::joinThreads()
 {
-  if(trj_exec_thread_                         .joinable()) trj_exec_thread_  .join();
-  if(replanning_enabled_ && replanning_thread_.joinable()) replanning_thread_.join();
-  if(col_check_thread_                        .joinable()) col_check_thread_ .join();
-  if(display_thread_                          .joinable()) display_thread_   .join();
-  if(benchmark_          && benchmark_thread_ .joinable()) benchmark_thread_ .join();
-  if(spawn_objs_         && spawn_obj_thread_ .joinable()) spawn_obj_thread_ .join();
+  std::unique_lock<std::mutex> lock(query_mtx_);
+  query_cv_.wait(lock,[&](){return running_threads_ == 0;});
 
   return true;
 }
@@ -681,21 +2041,48 @@ bool ReplannerManagerBase::run()
 
   attributeInitialization();
 
-  target_pub_         .publish(new_joint_state_         );
-  unscaled_target_pub_.publish(new_joint_state_unscaled_);
+  if(setpoint_streaming_)
+  {
+    /* The beginning of the trajectory, before the execution starts */
+    trajectory_msgs::JointTrajectory chunk, unscaled_chunk;
+    initChunk(chunk);
+    initChunk(unscaled_chunk);
 
-  ROS_BOLDWHITE_STREAM("Launching threads..");
+    double scaling = read_safe_scaling_? scaling_from_param_*readScalingTopics(): scaling_from_param_;
+    fillChunk(chunk,         scaling            );
+    fillChunk(unscaled_chunk,scaling_from_param_);
 
-  display_thread_         = std::thread(&ReplannerManagerBase::displayThread            ,this);  //it must be the first one launched, otherwise the first paths will be not displayed in time
-  if(spawn_objs_)
-    spawn_obj_thread_     = std::thread(&ReplannerManagerBase::spawnObjectsThread       ,this);
-  if(benchmark_)
-    benchmark_thread_     = std::thread(&ReplannerManagerBase::benchmarkThread          ,this);
-  if(replanning_enabled_)
-    replanning_thread_    = std::thread(&ReplannerManagerBase::replanningThread         ,this);
-  col_check_thread_       = std::thread(&ReplannerManagerBase::collisionCheckThread     ,this);
-  ros::Duration(0.1).sleep();
-  trj_exec_thread_        = std::thread(&ReplannerManagerBase::trajectoryExecutionThread,this);
+    chunk.header.stamp          = ros::Time::now();
+    unscaled_chunk.header.stamp = chunk.header.stamp;
+
+    chunk_pub_         .publish(chunk         );
+    unscaled_chunk_pub_.publish(unscaled_chunk);
+  }
+  else
+  {
+    target_pub_         .publish(new_joint_state_         );
+    unscaled_target_pub_.publish(new_joint_state_unscaled_);
+  }
+
+  if(shared_memory_target_)
+  {
+    if(not shared_target_ || shared_target_->getDof() != pnt_.positions.size())
+    {
+      shared_target_ = nullptr; //the previous memory is removed before creating the new one with the same name
+      shared_target_ = std::make_shared<SharedJointTarget>(shared_memory_name_,pnt_.positions.size(),std::max(shared_memory_capacity_,1));
+    }
+    writeSharedTarget();
+  }
+
+  ROS_BOLDWHITE_STREAM("Starting the query..");
+
+  launchThreads();
+
+  query_mtx_.lock();
+  running_threads_ = n_threads_;
+  query_id_++;
+  query_mtx_.unlock();
+  query_cv_.notify_all();
 
   return true;
 }
@@ -717,6 +2104,35 @@ double ReplannerManagerBase::readScalingTopics()
   return ovr;
 }
 
+void ReplannerManagerBase::initChunk(trajectory_msgs::JointTrajectory& chunk)
+{
+  unsigned int n_points = std::max(std::ceil(streaming_horizon_/dt_),1.0);
+  chunk.joint_names = joint_names_;
+  chunk.header.frame_id = model_frame_;
+  chunk.points.resize(n_points);
+}
+
+void ReplannerManagerBase::fillChunk(trajectory_msgs::JointTrajectory& chunk, const double& velocity_scaling)
+{
+  /* The setpoints that the thread would publish in the next ticks if neither the trajectory nor the override change */
+  for(unsigned int k=0;k<chunk.points.size();k++)
+  {
+    interpolator_.interpolate(ros::Duration(t_+k*scaling_*dt_),chunk.points[k],velocity_scaling);
+    chunk.points[k].time_from_start = ros::Duration(k*dt_);
+  }
+}
+
+void ReplannerManagerBase::writeSharedTarget()
+{
+  shared_target_buffer_.stamp               = ros::Time::now().toSec();
+  shared_target_buffer_.positions           = pnt_.positions          ;
+  shared_target_buffer_.velocities          = pnt_.velocities         ;
+  shared_target_buffer_.unscaled_positions  = pnt_unscaled_.positions ;
+  shared_target_buffer_.unscaled_velocities = pnt_unscaled_.velocities;
+
+  shared_target_->write(shared_target_buffer_);
+}
+
 void ReplannerManagerBase::trajectoryExecutionThread()
 {
   double  duration;
@@ -727,6 +2143,20 @@ void ReplannerManagerBase::trajectoryExecutionThread()
 
   ros::WallRate lp(trj_exec_thread_frequency_);
 
+  /* Setpoint streaming: chunks of the next streaming_horizon_ seconds are sent when the trajectory or the override change,
+   * or when half of the last chunk has been executed */
+  trajectory_msgs::JointTrajectory chunk, unscaled_chunk;
+  robot_trajectory::RobotTrajectoryPtr streamed_trj;
+  double streamed_scaling = -1.0;
+  unsigned int ticks_since_chunk = 0;
+  bool send_chunk = false;
+
+  if(setpoint_streaming_)
+  {
+    initChunk(chunk);
+    unscaled_chunk = chunk;
+  }
+
   while((not stop_) && ros::ok())
   {
     tic = ros::WallTime::now();
@@ -745,6 +2175,24 @@ void ReplannerManagerBase::trajectoryExecutionThread()
     interpolator_.interpolate(ros::Duration(t_),pnt_         ,scaling_           );
     interpolator_.interpolate(ros::Duration(t_),pnt_unscaled_,scaling_from_param_);
 
+    if(shared_memory_target_)
+      writeSharedTarget();
+
+    if(setpoint_streaming_)
+    {
+      ticks_since_chunk++;
+      send_chunk = (trajectory_->getTrj() != streamed_trj) || (scaling_ != streamed_scaling) || (2*ticks_since_chunk>=chunk.points.size());
+      if(send_chunk)
+      {
+        fillChunk(chunk,         scaling_           );
+        fillChunk(unscaled_chunk,scaling_from_param_);
+
+        streamed_trj = trajectory_->getTrj();
+        streamed_scaling = scaling_;
+        ticks_since_chunk = 0;
+      }
+    }
+
     for(unsigned int i=0; i<pnt_.positions.size();i++)
       point2project[i] = pnt_.positions[i];
 
@@ -765,16 +2213,30 @@ void ReplannerManagerBase::trajectoryExecutionThread()
       goal_reached_ = true;
     }
 
-    new_joint_state_.position              = pnt_.positions  ;
-    new_joint_state_.velocity              = pnt_.velocities ;
-    new_joint_state_.header.stamp          = ros::Time::now();
+    if(setpoint_streaming_)
+    {
+      if(send_chunk)
+      {
+        chunk.header.stamp          = ros::Time::now();
+        unscaled_chunk.header.stamp = chunk.header.stamp;
+
+        chunk_pub_         .publish(chunk         );
+        unscaled_chunk_pub_.publish(unscaled_chunk);
+      }
+    }
+    else
+    {
+      new_joint_state_.position              = pnt_.positions  ;
+      new_joint_state_.velocity              = pnt_.velocities ;
+      new_joint_state_.header.stamp          = ros::Time::now();
 
-    new_joint_state_unscaled_.position     = pnt_unscaled_.positions ;
-    new_joint_state_unscaled_.velocity     = pnt_unscaled_.velocities;
-    new_joint_state_unscaled_.header.stamp = ros::Time::now()        ;
+      new_joint_state_unscaled_.position     = pnt_unscaled_.positions ;
+      new_joint_state_unscaled_.velocity     = pnt_unscaled_.velocities;
+      new_joint_state_unscaled_.header.stamp = ros::Time::now()        ;
 
-    target_pub_         .publish(new_joint_state_)         ;
-    unscaled_target_pub_.publish(new_joint_state_unscaled_);
+      target_pub_         .publish(new_joint_state_)         ;
+      unscaled_target_pub_.publish(new_joint_state_unscaled_);
+    }
 
     toc = ros::WallTime::now();
     duration = (toc-tic).toSec();
@@ -1114,6 +2576,7 @@ void ReplannerManagerBase::benchmarkThread()
   std::vector<std::string>::iterator it;
   trajectory_msgs::JointTrajectoryPoint pnt;
   std::vector<double> replanning_time_vector;
+  std::vector<double> trajectory_time_vector;
   std::vector<std::string> already_collided_obj;
   Eigen::VectorXd old_current_configuration, current_configuration, current_configuration_3d, old_pnt_conf, pnt_conf;
 
@@ -1201,6 +2664,11 @@ void ReplannerManagerBase::benchmarkThread()
       replanning_time_vector.push_back(replanning_time_);
 
     replanning_time_ = 0.0;
+
+    if(trajectory_time_ != 0.0)
+      trajectory_time_vector.push_back(trajectory_time_);
+
+    trajectory_time_ = 0.0;
     bench_mtx_.unlock();
 
     /* Path length */
@@ -1227,7 +2695,7 @@ void ReplannerManagerBase::benchmarkThread()
         if(it>=already_collided_obj.end())
         {
           scene_mtx_.lock();
-          checker->setPlanningSceneMsg(planning_scene_msg_benchmark_);
+          setWorldMsg(checker,planning_scene_msg_benchmark_,false); //the full scene message has no octomap
           scene_mtx_.unlock();
 
           if(not checker->check(current_configuration)) //Did replanner know about this obstacle? If check(current_configuration) is false, replanner knew the obstacle
@@ -1275,6 +2743,13 @@ void ReplannerManagerBase::benchmarkThread()
   else
     max_replanning_time = 0.0;
 
+  double mean_trajectory_time = 0.0, max_trajectory_time = 0.0;
+  if(not trajectory_time_vector.empty())
+  {
+    mean_trajectory_time = std::accumulate(trajectory_time_vector.begin(),trajectory_time_vector.end(),0.0)/trajectory_time_vector.size();
+    max_trajectory_time = *(std::max_element(trajectory_time_vector.begin(),trajectory_time_vector.end()));
+  }
+
   bench_mtx_.lock();
   unsigned int number_of_objects = obj_ids_.size();
   bench_mtx_.unlock();
@@ -1322,6 +2797,8 @@ void ReplannerManagerBase::benchmarkThread()
   file.write((char*) &mean,                sizeof(mean               ));
   file.write((char*) &std_dev,             sizeof(std_dev            ));
   file.write((char*) &max_replanning_time, sizeof(max_replanning_time));
+  file.write((char*) &mean_trajectory_time,sizeof(mean_trajectory_time));
+  file.write((char*) &max_trajectory_time, sizeof(max_trajectory_time));
 
   file.flush();
   file.close();
@@ -1335,7 +2812,9 @@ void ReplannerManagerBase::benchmarkThread()
                       <<"\n* time: "<<real_time_
                       <<"\n* replanning time mean: "<<mean
                       <<"\n* replanning time std dev: "<<std_dev
-                      <<"\n* max replanning time: "<<max_replanning_time);
+                      <<"\n* max replanning time: "<<max_replanning_time
+                      <<"\n* trajectory time mean ("<<(online_trajectory_generator_? "online": time_parameterization_)<<"): "<<mean_trajectory_time
+                      <<"\n* max trajectory time: "<<max_trajectory_time);
 
   if(n_collisions == 0 && not success)
     throw std::runtime_error("no collisions but success false!");
@@ -1396,12 +2875,87 @@ PathPtr ReplannerManagerBase::trjPath(const PathPtr& path)
     trj_path->setConnections(conns);
 
   trj_path->removeNodes(1e-03);
+  if(adaptive_resampling_)
+    return adaptiveResample(trj_path,max_distance/5.0);
+
   trj_path->resample(max_distance/2.0);
   trj_path->simplify(0.05);
 
   return trj_path;
 }
 
+PathPtr ReplannerManagerBase::adaptiveResample(const PathPtr& path, const double& resolution)
+{
+  std::vector<Eigen::VectorXd> waypoints = path->getWaypoints();
+  unsigned int n = waypoints.size();
+  if(n<2)
+    return path;
+
+  Eigen::VectorXd max_velocity, max_acceleration;
+  trajectory_->jointLimits(max_velocity,max_acceleration);
+
+  /* Max speed and acceleration along each segment, speed at the waypoints (zero at the ends) as in the trajectory timing */
+  std::vector<Eigen::VectorXd> dir;
+  std::vector<double> length, max_speed, max_acc, speed;
+  OnlineTrajectoryGenerator::segmentLimits(waypoints,max_velocity,max_acceleration,dir,length,max_speed,max_acc,speed);
+
+  /* Distance from each end of a segment within which the speed changes; corners get at least one waypoint nearby */
+  std::vector<Eigen::VectorXd> resampled_waypoints;
+  resampled_waypoints.push_back(waypoints.front());
+  for(unsigned int k=0;k<n-1;k++)
+  {
+    if(length[k]<=0.0)
+      continue;
+
+    double v2 = max_speed[k]*max_speed[k];
+    bool corner_start = (k == 0  ) || (dir[k]-dir[k-1]).cwiseAbs().maxCoeff()>1.0e-6;
+    bool corner_end   = (k == n-2) || (dir[k+1]-dir[k]).cwiseAbs().maxCoeff()>1.0e-6;
+
+    double d_start = corner_start? std::max(resolution,(v2-speed[k  ]*speed[k  ])/(2.0*max_acc[k])): 0.0;
+    double d_end   = corner_end  ? std::max(resolution,(v2-speed[k+1]*speed[k+1])/(2.0*max_acc[k])): 0.0;
+
+    std::vector<double> s;
+    if(d_start+d_end>=length[k])
+    {
+      unsigned int n_steps = std::ceil(length[k]/resolution);
+      for(unsigned int i=1;i<n_steps;i++)
+        s.push_back(length[k]*i/n_steps);
+    }
+    else
+    {
+      unsigned int n_steps = std::ceil(d_start/resolution);
+      for(unsigned int i=1;i<=n_steps && d_start>0.0;i++)
+        s.push_back(d_start*i/n_steps);
+
+      n_steps = std::ceil(d_end/resolution);
+      for(unsigned int i=n_steps;i>=1 && d_end>0.0;i--)
+        s.push_back(length[k]-d_end*i/n_steps);
+    }
+
+    for(const double& si:s)
+      resampled_waypoints.push_back(waypoints[k]+si*dir[k]);
+
+    resampled_waypoints.push_back(waypoints[k+1]);
+  }
+
+  /* New path through the resampled waypoints */
+  MetricsPtr metrics = path->getMetrics();
+  std::vector<ConnectionPtr> conns;
+  NodePtr parent = std::make_shared<Node>(resampled_waypoints.front());
+  for(unsigned int i=1;i<resampled_waypoints.size();i++)
+  {
+    NodePtr child = std::make_shared<Node>(resampled_waypoints[i]);
+    ConnectionPtr conn = std::make_shared<Connection>(parent,child);
+    conn->setCost(metrics->cost(parent->getConfiguration(),child->getConfiguration()));
+    conn->add();
+
+    conns.push_back(conn);
+    parent = child;
+  }
+
+  return std::make_shared<Path>(conns,metrics,path->getChecker());
+}
+
 
 void ReplannerManagerBase::displayTrj(const DisplayPtr& disp)
 {
@@ -0,0 +1,70 @@
+#include "replanners_lib/replanner_managers/replanner_manager_portfolio.h"
+
+namespace pathplan
+{
+
+ReplannerManagerPortfolio::ReplannerManagerPortfolio(const PathPtr &current_path,
+                                                     const TreeSolverPtr &solver,
+                                                     const ros::NodeHandle &nh):ReplannerManagerMPRRT(current_path,solver,nh)
+{
+  portfolioParams();
+}
+
+ReplannerManagerPortfolio::~ReplannerManagerPortfolio()
+{
+  // The threads of a running query call the overrides of this class
+  shutdownThreads();
+}
+
+void ReplannerManagerPortfolio::portfolioParams()
+{
+  // The portfolio already runs its replanners concurrently, each one with its own checker
+  if(speculative_replanning_)
+  {
+    ROS_ERROR("speculative_replanning is not available for portfolio, disabled");
+    speculative_replanning_ = false;
+  }
+
+  if(!nh_.getParam("portfolio/replanners",portfolio_replanners_))
+  {
+    ROS_ERROR("portfolio/replanners not set, set {MARS,DRRT,MPRRT}");
+    portfolio_replanners_ = {"MARS","DRRT","MPRRT"};
+  }
+
+  if(!nh_.getParam("portfolio/n_threads",n_threads_portfolio_))
+  {
+    ROS_ERROR("portfolio/n_threads not set, set %u",(unsigned int) portfolio_replanners_.size());
+    n_threads_portfolio_ = portfolio_replanners_.size();
+  }
+  else
+  {
+    if(n_threads_portfolio_<1)
+    {
+      ROS_ERROR("portfolio/n_threads can not be less than 1, set 1");
+      n_threads_portfolio_ = 1;
+    }
+  }
+}
+
+bool ReplannerManagerPortfolio::haveToReplan(const bool path_obstructed)
+{
+  return alwaysReplan();
+}
+
+void ReplannerManagerPortfolio::initReplanner()
+{
+  double time_for_repl = 0.9*dt_replan_;
+  replanner_ = std::make_shared<pathplan::ReplannerPortfolio>(configuration_replan_, current_path_, time_for_repl, solver_,
+                                                              portfolio_replanners_, n_threads_portfolio_);
+}
+
+void ReplannerManagerPortfolio::updateReplanningCheckers(const bool& octree_changed)
+{
+  ReplannerManagerMPRRT::updateReplanningCheckers(octree_changed);
+
+  ReplannerPortfolioPtr portfolio = std::static_pointer_cast<ReplannerPortfolio>(replanner_);
+  for(const CollisionCheckerPtr& checker:portfolio->getCheckers())
+    setWorldMsg(checker,planning_scene_diff_msg_,octree_changed);
+}
+
+}
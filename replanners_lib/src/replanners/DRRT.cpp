@@ -114,9 +114,32 @@ bool DynamicRRT::trimInvalidTree(NodePtr& node)
   //Firstly trim the tree starting from the path to node
   bool obstructed;
   std::vector<ConnectionPtr> node2goal = tree->getConnectionToNode(node); //Note: the root must be the goal (set in regrowRRT())
+
+  if(batch_checker_) //check at once the connections up to the first obstructed one, the loop below then finds them recently checked
+  {
+    std::vector<ConnectionPtr> to_check;
+    for(const ConnectionPtr &conn: node2goal)
+    {
+      if(not conn->isRecentlyChecked())
+        to_check.push_back(conn);
+    }
+
+    std::vector<int> status = batch_checker_->checkConnections(to_check,true,max_time_-(ros::WallTime::now()-tic).toSec());
+    for(unsigned int i=0;i<to_check.size();i++)
+    {
+      if(status.at(i) == BatchCollisionChecker::UNCHECKED)
+        continue;
+
+      if(status.at(i) == BatchCollisionChecker::OBSTRUCTED)
+        to_check.at(i)->setCost(std::numeric_limits<double>::infinity());
+
+      to_check.at(i)->setRecentlyChecked(true);
+      checked_connections_.push_back(to_check.at(i));
+    }
+  }
   for(const ConnectionPtr &conn: node2goal)
   {
-    if((ros::WallTime::now()-tic).toSec()>=max_time_)
+    if((ros::WallTime::now()-tic).toSec()>=max_time_ || stop_)
     {
       if(verbose_)
         ROS_INFO("Time to trim expired");
@@ -228,7 +251,7 @@ bool DynamicRRT::regrowRRT(NodePtr& node)
   assert(max_distance>0.0);
 
   double time = (ros::WallTime::now()-tic).toSec();
-  while(time<max_time_ && not success_)
+  while(time<max_time_ && not success_ && not stop_)
   {
     NodePtr new_node;
     Eigen::VectorXd conf = sampler_->sample();
@@ -132,7 +132,7 @@ bool DynamicRRTStar::connectBehindObs(const NodePtr& node)
   double max_time = 0.98*max_time_;
   double time = (ros::WallTime::now()-tic).toSec();
 
-  while(time<0.98*max_time)
+  while(time<0.98*max_time && not stop_)
   {
     q = sampler.sample();
 
@@ -621,8 +621,51 @@ bool MARS::findValidSolution(const std::multimap<double,std::vector<ConnectionPt
         number_of_candidates++;
 
         free = true;
+
+        if(batch_checker_) //check at once the connections not recently checked, up to the first obstructed one
+        {
+          std::vector<ConnectionPtr> to_check;
+          for(const ConnectionPtr& conn: solution_pair.second)
+          {
+            if(not conn->isRecentlyChecked())
+              to_check.push_back(conn);
+          }
+
+          double remaining_time = available_time_-(ros::WallTime::now()-tic_replanning_).toSec();
+          std::vector<int> status = batch_checker_->checkConnections(to_check,true,remaining_time);
+          for(unsigned int j=0;j<to_check.size();j++)
+          {
+            const ConnectionPtr& conn = to_check.at(j);
+            if(status.at(j) == BatchCollisionChecker::UNCHECKED)
+              continue;
+
+            conn->setRecentlyChecked(true);
+            flagged_connections_.push_back(conn);
+
+            if(status.at(j) == BatchCollisionChecker::OBSTRUCTED)
+            {
+              free = false;
+
+              /* Save the invalid connection */
+              invalid_connection_ptr invalid_conn = std::make_shared<invalid_connection>();
+              invalid_conn->connection = conn;
+              invalid_conn->cost = conn->getCost();
+              invalid_connections_.push_back(invalid_conn);
+
+              /* Set the cost equal to infinity */
+              conn->setCost(std::numeric_limits<double>::infinity());
+
+              if(verbose)
+                ROS_INFO_STREAM("conn "<<conn<<" obstructed!");
+            }
+          }
+        }
+
         for(const ConnectionPtr& conn: solution_pair.second)
         {
+          if(not free)
+            break;
+
           if(not conn->isRecentlyChecked())
           {
             conn->setRecentlyChecked(true);
@@ -1527,7 +1570,7 @@ bool MARS::pathSwitch(const PathPtr &current_path,
 
     toc=ros::WallTime::now();
     time = pathSwitch_max_time_ - (toc-tic).toSec();
-    if((!an_obstacle_ && time<time_percentage_variability_*pathSwitch_cycle_time_mean_ && pathSwitch_cycle_time_mean_ != std::numeric_limits<double>::infinity()) || time<=0.0)  //if there is an obstacle, you should use the entire available time to find a feasible solution
+    if((!an_obstacle_ && time<time_percentage_variability_*pathSwitch_cycle_time_mean_ && pathSwitch_cycle_time_mean_ != std::numeric_limits<double>::infinity()) || time<=0.0 || stop_)  //if there is an obstacle, you should use the entire available time to find a feasible solution
     {
       if(pathSwitch_verbose_)
         ROS_BLUE_STREAM("TIME OUT! max time: "<<pathSwitch_max_time_<<", time_available: "<<time<<", time needed for a new cycle: "<<time_percentage_variability_*pathSwitch_cycle_time_mean_<<"; "<<remaining_goals<<" goals not considered.");
@@ -1629,6 +1672,7 @@ bool MARS::informedOnlineReplanning(const double &max_time)
     MAX_TIME = max_time;
 
   available_time_ = MAX_TIME;
+  tic_replanning_ = tic;
   const double TIME_LIMIT = 0.85*MAX_TIME; //seconds
   const int CONT_LIMIT = 5;
 
@@ -1778,7 +1822,7 @@ bool MARS::informedOnlineReplanning(const double &max_time)
       pathSwitch_cycle_time_mean_ = std::numeric_limits<double>::infinity();  //reset
 
     toc = ros::WallTime::now();
-    available_time_ = MAX_TIME - (toc-tic).toSec();
+    available_time_ = stop_? -1.0: (MAX_TIME - (toc-tic).toSec());
 
     double min_time_to_launch_pathSwitch;
     if(informedOnlineReplanning_disp_)
@@ -2300,4 +2344,200 @@ bool MARS::replan()
 
   return path_changed;
 }
+
+bool MARS::purgeSubtree(const NodePtr& node, const std::unordered_set<Node*>& kept_nodes, std::unordered_set<Node*>& tree_nodes, unsigned int& removed_nodes)
+{
+  // Removes the subtree of node except the kept nodes and their ancestors, true if node has been removed.
+  // The removed nodes are erased from tree_nodes
+  if(kept_nodes.find(node.get()) != kept_nodes.end())
+    return false;
+
+  bool removable = true;
+  for(const NodePtr& child:node->getChildren())
+    removable = purgeSubtree(child,kept_nodes,tree_nodes,removed_nodes) && removable;
+
+  if(not removable)
+    return false;
+
+  NodePtr n = node;  //no children left, the white list of the tree is not needed
+  std::vector<NodePtr> white_list;
+  if(not tree_->purgeFromHere(n,white_list,removed_nodes))
+    return false;
+
+  tree_nodes.erase(node.get());
+  return true;
+}
+
+unsigned int MARS::compactTree(const unsigned int& node_budget, const unsigned int& n_other_paths_to_keep, const std::vector<NodePtr>& white_list,
+                               const double& max_time)
+{
+  /* Garbage collection of tree and net, to be called between two replannings. It keeps the current path,
+   * the replanned path and the n_other_paths_to_keep cheapest other paths, drops the other ones, collapses
+   * the collinear nodes of the kept other paths and removes the tree leaves exceeding node_budget.
+   * The other paths are ranked by cost only: a path beyond the n_other_paths_to_keep cheapest ones is dropped even if
+   * it is the only one through a region, which n_other_paths_to_keep should account for.
+   * Every removed node is also erased from the node vector of the tree (linear in its size), so the removal of the leaves,
+   * the most expensive part, stops after max_time seconds and the budget is reached over the next calls */
+
+  if(not tree_)
+    return 0;
+
+  ros::WallTime tic = ros::WallTime::now();
+
+  clearInvalidConnections();
+  clearFlaggedConnections();
+
+  unsigned int removed_nodes = 0;
+
+  std::unordered_set<Node*> protected_nodes;
+  for(const NodePtr& n:white_list)
+    protected_nodes.insert(n.get());
+
+  protected_nodes.insert(tree_->getRoot().get());
+  protected_nodes.insert(paths_start_.get());
+  protected_nodes.insert(goal_node_.get());
+
+  std::vector<PathPtr> paths = {current_path_};
+  if(replanned_path_)
+    paths.push_back(replanned_path_);
+
+  for(const PathPtr& p:paths)
+  {
+    for(const ConnectionPtr& conn:tree_->getConnectionToNode(p->getStartNode()))
+      protected_nodes.insert(conn->getParent().get());
+
+    for(const NodePtr& n:p->getNodes())
+      protected_nodes.insert(n.get());
+  }
+
+  /* Keep the cheapest other paths, the other ones are removed from the tree */
+  std::multimap<double,PathPtr> sorted_other_paths;
+  for(const PathPtr& p:other_paths_)
+    sorted_other_paths.insert(std::pair<double,PathPtr>(p->cost(),p));
+
+  std::vector<PathPtr> kept_other_paths, dropped_other_paths;
+  for(const std::pair<double,PathPtr>& pair:sorted_other_paths)
+    (kept_other_paths.size()<n_other_paths_to_keep)? kept_other_paths.push_back(pair.second):
+                                                     dropped_other_paths.push_back(pair.second);
+
+  // Number of kept other paths through each node, to not collapse the shared ones
+  std::unordered_set<Node*> kept_nodes = protected_nodes;
+  std::unordered_map<Node*,unsigned int> kept_paths_through;
+  for(const PathPtr& p:kept_other_paths)
+  {
+    for(const NodePtr& n:p->getNodes())
+    {
+      kept_nodes.insert(n.get());
+      kept_paths_through[n.get()]++;
+    }
+  }
+
+  std::unordered_set<Node*> tree_nodes;
+  if(not dropped_other_paths.empty())
+  {
+    for(const NodePtr& n:tree_->getNodesConst())
+      tree_nodes.insert(n.get());
+  }
+
+  for(const PathPtr& p:dropped_other_paths)
+  {
+    for(const NodePtr& n:p->getNodes())
+    {
+      if(kept_nodes.find(n.get()) != kept_nodes.end() || tree_nodes.find(n.get()) == tree_nodes.end())
+        continue;
+
+      purgeSubtree(n,kept_nodes,tree_nodes,removed_nodes);
+    }
+  }
+
+  /* Collapse the collinear nodes of the kept other paths which are not shared with other paths */
+  for(const PathPtr& p:kept_other_paths)
+  {
+    std::vector<NodePtr> nodes = p->getNodes();
+    for(unsigned int i=1;i<nodes.size()-1;i++)
+    {
+      NodePtr n = nodes.at(i);
+
+      if(protected_nodes.find(n.get()) != protected_nodes.end() || kept_paths_through.at(n.get())>1)
+        continue;
+
+      if(n->getParentConnectionsSize() != 1 || n->getChildConnectionsSize() != 1 ||
+         n->getNetParentConnectionsSize() != 0 || n->getNetChildConnectionsSize() != 0)
+        continue;
+
+      ConnectionPtr parent_conn = n->parentConnection(0);
+      ConnectionPtr child_conn  = n->childConnection(0);
+
+      if(parent_conn->getCost() == std::numeric_limits<double>::infinity() || child_conn->getCost() == std::numeric_limits<double>::infinity())
+        continue;
+
+      Eigen::VectorXd parent_conf = parent_conn->getParent()->getConfiguration();
+      Eigen::VectorXd child_conf  = child_conn ->getChild ()->getConfiguration();
+      double detour = (n->getConfiguration()-parent_conf).norm()+(child_conf-n->getConfiguration()).norm()-(child_conf-parent_conf).norm();
+
+      if(detour<TOLERANCE && p->removeNode(n,{})) //the node is removed also from the tree
+      {
+        kept_nodes.erase(n.get());
+        removed_nodes++;
+      }
+    }
+  }
+
+  /* Cap the tree size removing the leaves with the highest cost-to-come first. The costs-to-come are computed
+   * once from the root, a parent left without children becomes a leaf in turn */
+  std::vector<NodePtr> nodes = tree_->getNodesConst();
+  unsigned int n_nodes = nodes.size();
+
+  if(n_nodes>node_budget)
+  {
+    std::unordered_map<Node*,double> cost_to_come;
+    std::vector<NodePtr> stack = {tree_->getRoot()};
+    cost_to_come[tree_->getRoot().get()] = 0.0;
+    while(not stack.empty())
+    {
+      NodePtr n = stack.back();
+      stack.pop_back();
+
+      double cost = cost_to_come.at(n.get());
+      for(const ConnectionPtr& conn:n->getChildConnections())
+      {
+        cost_to_come[conn->getChild().get()] = cost+conn->getCost();
+        stack.push_back(conn->getChild());
+      }
+    }
+
+    std::vector<NodePtr> no_white_list;
+    std::priority_queue<std::pair<double,NodePtr>> leaves;
+    for(const NodePtr& n:nodes)
+    {
+      if(n->getChildConnectionsSize() == 0 && kept_nodes.find(n.get()) == kept_nodes.end())
+        leaves.push(std::pair<double,NodePtr>(cost_to_come[n.get()],n));
+    }
+
+    while(n_nodes>node_budget && not leaves.empty() && (ros::WallTime::now()-tic).toSec()<max_time)
+    {
+      NodePtr leaf = leaves.top().second;
+      leaves.pop();
+
+      NodePtr parent = (leaf->getParentConnectionsSize()>0)? leaf->parentConnection(0)->getParent(): nullptr;
+
+      if(not tree_->purgeFromHere(leaf,no_white_list,removed_nodes))
+        continue;
+
+      n_nodes--;
+
+      if(parent && parent->getChildConnectionsSize() == 0 && kept_nodes.find(parent.get()) == kept_nodes.end())
+        leaves.push(std::pair<double,NodePtr>(cost_to_come[parent.get()],parent));
+    }
+  }
+
+  other_paths_ = kept_other_paths;
+  admissible_other_paths_ = other_paths_;
+  net_->setTree(tree_);
+
+  if(verbose_)
+    ROS_INFO_STREAM("Tree compaction: "<<removed_nodes<<" nodes removed, "<<dropped_other_paths.size()<<" other paths dropped, "<<tree_->getNodesConst().size()<<" nodes left");
+
+  return removed_nodes;
+}
 }
@@ -88,7 +88,7 @@ bool MPRRT::asyncComputeConnectingPath(const Eigen::VectorXd path1_node_conf,
         best_cost = new_cost;
       }
     }
-  } while((0.98*max_time_-(ros::WallTime::now()-tic).toSec())>0.0 && ros::ok());
+  } while((0.98*max_time_-(ros::WallTime::now()-tic).toSec())>0.0 && ros::ok() && not stop_);
 
   mtx_.lock();
   connecting_path_vector_.at(index) = best_solution;
@@ -61,7 +61,7 @@ bool AnytimeDynamicRRT::improvePath(NodePtr &node, const double& max_time)
   PathPtr solution;
   double cost2beat;
   double time = (ros::WallTime::now()-tic).toSec();
-  while(time<max_time && n_fail<FAILED_ITER)
+  while(time<max_time && n_fail<FAILED_ITER && not stop_)
   {
     cost2beat = (1-imprv)*path_cost;
 
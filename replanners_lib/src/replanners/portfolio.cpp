@@ -0,0 +1,280 @@
+#include "replanners_lib/replanners/portfolio.h"
+
+namespace pathplan
+{
+
+ReplannerPortfolio::ReplannerPortfolio(Eigen::VectorXd& current_configuration,
+                                       PathPtr& current_path,
+                                       const double& max_time,
+                                       const TreeSolverPtr& solver,
+                                       const std::vector<std::string>& replanners_names,
+                                       const unsigned int& n_threads): ReplannerBase(current_configuration,current_path,max_time,solver)
+{
+  std::vector<std::string> available_replanners = {"MARS","DRRT","DRRTStar","anytimeDRRT","MPRRT"};
+
+  for(const std::string& name:replanners_names)
+  {
+    if(std::find(available_replanners.begin(),available_replanners.end(),name) == available_replanners.end())
+      ROS_ERROR("Replanner %s not available in the portfolio",name.c_str());
+    else if(std::find(replanners_names_.begin(),replanners_names_.end(),name) != replanners_names_.end())
+      ROS_ERROR("Replanner %s already in the portfolio",name.c_str());
+    else
+      replanners_names_.push_back(name);
+  }
+
+  if(replanners_names_.empty())
+  {
+    ROS_ERROR("No valid replanner in the portfolio, MARS and DRRT used");
+    replanners_names_ = {"MARS","DRRT"};
+  }
+
+  n_threads_ = std::max(n_threads,(unsigned int) replanners_names_.size());
+
+  wins_  .resize(replanners_names_.size(),0);
+  trials_.resize(replanners_names_.size(),0);
+
+  // At most one instance per thread: cloning a checker is costly, so they are created once
+  for(unsigned int i=0;i<n_threads_;i++)
+    checkers_.push_back(checker_->clone());
+
+  allocateThreads();
+}
+
+void ReplannerPortfolio::allocateThreads()
+{
+  // Each replanner keeps one thread, the spare ones are shared proportionally to the (smoothed) wins,
+  // using the largest remainder method
+  threads_.assign(replanners_names_.size(),1);
+
+  unsigned int spare_threads = n_threads_-replanners_names_.size();
+  if(spare_threads == 0)
+    return;
+
+  double total_weight = std::accumulate(wins_.begin(),wins_.end(),0.0)+wins_.size();
+
+  std::vector<double> remainders;
+  unsigned int assigned_threads = 0;
+  for(unsigned int i=0;i<replanners_names_.size();i++)
+  {
+    double quota = spare_threads*(wins_.at(i)+1.0)/total_weight;
+    threads_.at(i) += std::floor(quota);
+    assigned_threads += std::floor(quota);
+    remainders.push_back(quota-std::floor(quota));
+  }
+
+  while(assigned_threads<spare_threads)
+  {
+    unsigned int idx = std::max_element(remainders.begin(),remainders.end())-remainders.begin();
+    threads_.at(idx)++;
+    remainders.at(idx) = -1.0;
+    assigned_threads++;
+  }
+}
+
+std::vector<PathPtr> ReplannerPortfolio::otherPathsFromStart(const CollisionCheckerPtr& checker)
+{
+  /* The solutions which lost the last cycle start from a configuration of the current path (the replanning one at that time),
+   * while MARS requires its other paths to start where its current path starts: the part of the current path before it is prepended */
+  std::vector<PathPtr> other_paths;
+  Eigen::VectorXd start = current_path_->getWaypoints().front();
+
+  for(const PathPtr& other_path:other_paths_)
+  {
+    Eigen::VectorXd junction = other_path->getWaypoints().front();
+    if(not current_path_->findConnection(junction))  //the robot has already overtaken it
+      continue;
+
+    std::vector<Eigen::VectorXd> waypoints;
+    if((junction-start).norm()>TOLERANCE)
+    {
+      waypoints = current_path_->getSubpathToConf(junction,true)->getWaypoints();
+      waypoints.pop_back();
+    }
+
+    std::vector<Eigen::VectorXd> other_waypoints = other_path->getWaypoints();
+    waypoints.insert(waypoints.end(),other_waypoints.begin(),other_waypoints.end());
+
+    std::vector<ConnectionPtr> conns;
+    NodePtr parent = std::make_shared<Node>(waypoints.front());
+    for(unsigned int i=1;i<waypoints.size();i++)
+    {
+      NodePtr child = std::make_shared<Node>(waypoints.at(i));
+
+      ConnectionPtr conn = std::make_shared<Connection>(parent,child,false);
+      conn->setCost(metrics_->cost(parent->getConfiguration(),child->getConfiguration()));
+      conn->add();
+
+      conns.push_back(conn);
+      parent = child;
+    }
+
+    if(not conns.empty())
+      other_paths.push_back(std::make_shared<Path>(conns,metrics_,checker));
+  }
+
+  return other_paths;
+}
+
+ReplannerBasePtr ReplannerPortfolio::createReplanner(const std::string& name, const unsigned int& n_threads, const CollisionCheckerPtr& checker)
+{
+  // Each replanner works on its own copy of path, tree and solver, and with its own checker
+  PathPtr path = ReplannerBase::clonePathWithTree(current_path_,checker,solver_->getMaxDistance());
+  if(not path)
+    return nullptr;
+
+  // MARS needs the tree rooted at the start of the path
+  if(name == "MARS" && path->getTree()->getRoot() != path->getStartNode())
+  {
+    if(not path->getTree()->changeRoot(path->getStartNode()))
+      return nullptr;
+  }
+
+  SamplerPtr sampler = std::make_shared<InformedSampler>(lb_,ub_,lb_,ub_);
+  TreeSolverPtr solver = solver_->clone(metrics_->clone(),checker,sampler);
+  solver->importFromSolver(solver_);
+
+  Eigen::VectorXd configuration = current_configuration_;
+  ReplannerBasePtr replanner;
+
+  if(name == "MARS")
+  {
+    std::vector<PathPtr> other_paths = otherPathsFromStart(checker);
+    replanner = std::make_shared<MARS>(configuration,path,max_time_,solver,other_paths);
+  }
+  else if(name == "DRRT")
+    replanner = std::make_shared<DynamicRRT>(configuration,path,max_time_,solver);
+  else if(name == "DRRTStar")
+    replanner = std::make_shared<DynamicRRTStar>(configuration,path,max_time_,solver);
+  else if(name == "anytimeDRRT")
+    replanner = std::make_shared<AnytimeDynamicRRT>(configuration,path,max_time_,solver);
+  else if(name == "MPRRT")
+    replanner = std::make_shared<MPRRT>(configuration,path,max_time_,solver,n_threads);
+
+  if(replanner)
+    replanner->setVerbosity(false);
+
+  return replanner;
+}
+
+bool ReplannerPortfolio::replan()
+{
+  ros::WallTime tic = ros::WallTime::now();
+
+  success_ = false;
+  replanned_path_ = current_path_;
+
+  // MPRRT uses its threads internally, the other replanners run one instance per thread
+  std::vector<ReplannerBasePtr> replanners;
+  std::vector<unsigned int> replanners_idx;
+  for(unsigned int i=0;i<replanners_names_.size();i++)
+  {
+    unsigned int n_instances = (replanners_names_.at(i) == "MPRRT")? 1:threads_.at(i);
+    for(unsigned int j=0;j<n_instances;j++)
+    {
+      ReplannerBasePtr replanner = createReplanner(replanners_names_.at(i),threads_.at(i),checkers_.at(replanners.size()));
+      if(replanner)
+      {
+        replanners.push_back(replanner);
+        replanners_idx.push_back(i);
+      }
+    }
+  }
+
+  // All the replanners share the same deadline
+  double max_time = max_time_-(ros::WallTime::now()-tic).toSec();
+  if(max_time<=0.0 || replanners.empty())
+    return false;
+
+  // Each task signals its end, the first valid solution is recorded
+  std::mutex done_mtx;
+  std::condition_variable done_cv;
+  unsigned int n_done = 0;
+  int first_idx = -1;
+
+  std::vector<std::shared_future<bool>> tasks;
+  for(unsigned int i=0;i<replanners.size();i++)
+  {
+    replanners.at(i)->setMaxTime(max_time);
+    tasks.push_back(std::async(std::launch::async,[&,i]() ->bool{
+      bool solved = replanners.at(i)->replan();
+
+      std::lock_guard<std::mutex> lock(done_mtx);
+      if(solved && first_idx<0)
+        first_idx = i;
+
+      n_done++;
+      done_cv.notify_one();
+
+      return solved;
+    }));
+  }
+
+  // The first solution stops the other replanners, which return the best solution they found so far
+  std::unique_lock<std::mutex> lock(done_mtx);
+  done_cv.wait(lock,[&]() ->bool{return first_idx>=0 || n_done == tasks.size();});
+  lock.unlock();
+
+  for(const ReplannerBasePtr& replanner:replanners)
+    replanner->stop();
+
+  for(const std::shared_future<bool>& task:tasks)
+    task.wait();
+
+  std::vector<bool> took_part(replanners_names_.size(),false);
+  double best_cost = std::numeric_limits<double>::infinity();
+  int best_idx = -1;
+
+  for(unsigned int i=0;i<replanners.size();i++)
+  {
+    took_part.at(replanners_idx.at(i)) = true;
+
+    if(not tasks.at(i).get())
+      continue;
+
+    double cost = replanners.at(i)->getReplannedPath()->cost();
+    if(cost<best_cost)
+    {
+      best_cost = cost;
+      best_idx = i;
+    }
+  }
+
+  for(unsigned int i=0;i<replanners_names_.size();i++)
+  {
+    if(took_part.at(i))
+      trials_.at(i)++;
+  }
+
+  other_paths_.clear();
+  for(unsigned int i=0;i<replanners.size();i++)
+  {
+    if((int) i != best_idx && tasks.at(i).get())
+      other_paths_.push_back(replanners.at(i)->getReplannedPath());
+  }
+
+  /* The others are stopped by the first valid solution, so the win goes to the fastest replanner, which drives the allocation of the threads.
+   * The cheapest solution available is adopted anyway */
+  if(best_idx>=0)
+  {
+    unsigned int winner = replanners_idx.at(first_idx);
+    wins_.at(winner)++;
+    last_winner_ = replanners_names_.at(winner);
+
+    replanned_path_ = replanners.at(best_idx)->getReplannedPath();
+    replanned_path_->setChecker(checker_);
+    success_ = true;
+
+    if(verbose_)
+    {
+      ROS_INFO_STREAM("Portfolio: "<<last_winner_<<" found the first solution, "<<replanners_names_.at(replanners_idx.at(best_idx))<<
+                      " the best one with cost "<<best_cost<<" in "<<(ros::WallTime::now()-tic).toSec()<<" s");
+      for(unsigned int i=0;i<replanners_names_.size();i++)
+        ROS_INFO_STREAM(replanners_names_.at(i)<<" wins: "<<wins_.at(i)<<"/"<<trials_.at(i)<<" threads: "<<threads_.at(i));
+    }
+  }
+
+  allocateThreads();
+
+  return success_;
+}
+}
@@ -22,6 +22,7 @@ ReplannerBase::ReplannerBase(const Eigen::VectorXd& current_configuration,
 
   max_time_ = max_time;
   success_ = false;
+  stop_ = false;
 
   disp_ = nullptr;
   verbose_ = false;
@@ -33,4 +34,69 @@ ReplannerBase::~ReplannerBase()
 {
 }
 
+PathPtr ReplannerBase::clonePathWithTree(const PathPtr& path, const CollisionCheckerPtr& checker, const double& max_distance)
+{
+  TreePtr tree = path->getTree();
+  if(tree)
+  {
+    std::vector<NodePtr> nodes = tree->getNodesConst();
+    std::unordered_map<Node*,NodePtr> clones;
+    for(const NodePtr& n:nodes)
+      clones[n.get()] = std::make_shared<Node>(n->getConfiguration());
+
+    for(const NodePtr& n:nodes)
+    {
+      for(const ConnectionPtr& conn:n->getChildConnections())
+      {
+        std::unordered_map<Node*,NodePtr>::iterator it = clones.find(conn->getChild().get());
+        if(it == clones.end())
+          continue;
+
+        ConnectionPtr conn_clone = std::make_shared<Connection>(clones.at(n.get()),it->second,false);
+        conn_clone->setCost(conn->getCost());
+        conn_clone->add();
+      }
+    }
+
+    std::vector<ConnectionPtr> connections;
+    for(const ConnectionPtr& conn:path->getConnections())
+    {
+      std::unordered_map<Node*,NodePtr>::iterator parent = clones.find(conn->getParent().get());
+      std::unordered_map<Node*,NodePtr>::iterator child  = clones.find(conn->getChild ().get());
+      if(parent == clones.end() || child == clones.end() || child->second->getParentConnectionsSize() == 0 ||
+         child->second->parentConnection(0)->getParent() != parent->second)
+        break;
+
+      connections.push_back(child->second->parentConnection(0));
+    }
+
+    if(connections.size() == path->getConnectionsSize())
+    {
+      NodePtr root = clones.at(tree->getRoot().get());
+      TreePtr tree_clone = std::make_shared<Tree>(root,max_distance,checker,path->getMetrics());
+      for(const NodePtr& n:nodes)
+      {
+        if(n != tree->getRoot())
+          tree_clone->addNode(clones.at(n.get()),false);
+      }
+
+      PathPtr path_clone = std::make_shared<Path>(connections,path->getMetrics(),checker);
+      path_clone->setTree(tree_clone);
+
+      return path_clone;
+    }
+  }
+
+  PathPtr path_clone = path->clone();
+  path_clone->setChecker(checker);
+
+  TreePtr tree_clone = std::make_shared<Tree>(path_clone->getStartNode(),max_distance,checker,path_clone->getMetrics());
+  if(not tree_clone->addBranch(path_clone->getConnections()))
+    return nullptr;
+
+  path_clone->setTree(tree_clone);
+
+  return path_clone;
+}
+
 }
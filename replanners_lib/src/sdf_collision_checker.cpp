@@ -0,0 +1,301 @@
+#include "replanners_lib/sdf_collision_checker.h"
+
+namespace pathplan
+{
+
+SdfCollisionChecker::SdfCollisionChecker(const planning_scene::PlanningScenePtr& planning_scene,
+                                         const std::string& group_name,
+                                         const DistanceFieldPtr& distance_field,
+                                         const std::vector<std::string>& sphere_links,
+                                         const Eigen::Matrix4Xd& spheres,
+                                         const bool& check_self_collisions,
+                                         const double& min_distance):
+  CollisionChecker(min_distance),
+  planning_scene_(planning_scene),
+  group_name_(group_name),
+  distance_field_(distance_field),
+  owns_distance_field_(false),
+  check_self_collisions_(check_self_collisions)
+{
+  state_ = std::make_shared<robot_state::RobotState>(planning_scene_->getCurrentState());
+  jmg_ = state_->getJointModelGroup(group_name_);
+  if(not jmg_)
+    throw std::invalid_argument("group "+group_name_+" does not exist");
+
+  if(sphere_links.empty())
+  {
+    // One sphere for each link of the group, circumscribing the bounding box of its collision geometry
+    std::vector<Eigen::Vector4d> link_spheres;
+    for(const robot_model::LinkModel* link:jmg_->getLinkModels())
+    {
+      if(link->getShapes().empty())
+        continue;
+
+      Eigen::Vector4d sphere;
+      sphere<<link->getCenteredBoundingBoxOffset(),0.5*link->getShapeExtentsAtOrigin().norm();
+
+      robot_sphere_links_.push_back(link);
+      link_spheres.push_back(sphere);
+    }
+
+    robot_spheres_.resize(4,link_spheres.size());
+    for(unsigned int i=0;i<link_spheres.size();i++)
+      robot_spheres_.col(i) = link_spheres.at(i);
+  }
+  else
+  {
+    if((long) sphere_links.size() != spheres.cols())
+      throw std::invalid_argument("each sphere needs its link");
+
+    for(const std::string& name:sphere_links)
+    {
+      const robot_model::LinkModel* link = state_->getRobotModel()->getLinkModel(name);
+      if(not link)
+        throw std::invalid_argument("link "+name+" does not exist");
+
+      robot_sphere_links_.push_back(link);
+    }
+    robot_spheres_ = spheres;
+  }
+
+  const std::vector<const robot_model::LinkModel*>& links = jmg_->getUpdatedLinkModelsWithGeometry();
+  link_lever_arms_.setZero(links.size(),jmg_->getActiveJointModels().size());
+  for(unsigned int k=0;k<links.size();k++)
+  {
+    double reach = links.at(k)->getCenteredBoundingBoxOffset().norm()+0.5*links.at(k)->getShapeExtentsAtOrigin().norm();
+    link_lever_arms_.row(k) = leverArms(jmg_,links.at(k),reach);
+  }
+
+  updateAttachedBodies();
+}
+
+Eigen::RowVectorXd SdfCollisionChecker::leverArms(const robot_state::JointModelGroup* jmg, const robot_model::LinkModel* link, const double& reach)
+{
+  const std::vector<const robot_model::JointModel*>& joints = jmg->getActiveJointModels();
+  Eigen::RowVectorXd lever_arms = Eigen::RowVectorXd::Zero(joints.size());
+
+  // Walking from the link towards the root, the distance from each joint is bounded
+  // by the sum of the (fixed) link lengths crossed so far, whatever the configuration
+  double distance = reach;
+  while(link)
+  {
+    const robot_model::JointModel* joint = link->getParentJointModel();
+    if(not joint)
+      break;
+
+    std::vector<const robot_model::JointModel*>::const_iterator it = std::find(joints.begin(),joints.end(),joint);
+    if(it != joints.end())
+    {
+      unsigned int j = it-joints.begin();
+      if(joint->getType() == robot_model::JointModel::REVOLUTE)
+        lever_arms(j) = distance;
+      else if(joint->getType() == robot_model::JointModel::PRISMATIC)
+        lever_arms(j) = 1.0;
+      else
+        lever_arms(j) = 1.0+distance;
+    }
+
+    if(joint->getType() == robot_model::JointModel::PRISMATIC)
+    {
+      const robot_model::VariableBounds& bounds = joint->getVariableBounds().at(0);
+      distance += std::max(std::abs(bounds.min_position_),std::abs(bounds.max_position_));
+    }
+
+    distance += link->getJointOriginTransform().translation().norm();
+    link = joint->getParentLinkModel();
+  }
+
+  return lever_arms;
+}
+
+void SdfCollisionChecker::updateAttachedBodies()
+{
+  /* One sphere for each shape of the attached bodies, circumscribing it, on the link the body is attached to */
+  std::vector<const robot_state::AttachedBody*> bodies;
+  state_->getAttachedBodies(bodies);
+
+  sphere_links_ = robot_sphere_links_;
+  std::vector<Eigen::Vector4d> attached_spheres;
+  for(const robot_state::AttachedBody* body:bodies)
+  {
+    for(unsigned int i=0;i<body->getShapes().size() && i<body->getFixedTransforms().size();i++)
+    {
+      Eigen::Vector3d center;
+      double radius;
+      shapes::computeShapeBoundingSphere(body->getShapes().at(i).get(),center,radius);
+
+      Eigen::Vector4d sphere;
+      sphere<<body->getFixedTransforms().at(i)*center,radius;
+
+      sphere_links_.push_back(body->getAttachedLink());
+      attached_spheres.push_back(sphere);
+    }
+  }
+
+  spheres_.resize(4,robot_spheres_.cols()+attached_spheres.size());
+  spheres_.leftCols(robot_spheres_.cols()) = robot_spheres_;
+  for(unsigned int i=0;i<attached_spheres.size();i++)
+    spheres_.col(robot_spheres_.cols()+i) = attached_spheres.at(i);
+
+  computeLeverArms();
+}
+
+void SdfCollisionChecker::computeLeverArms()
+{
+  lever_arms_.setZero(spheres_.cols(),jmg_->getActiveJointModels().size());
+  for(unsigned int k=0;k<sphere_links_.size();k++)
+    lever_arms_.row(k) = leverArms(jmg_,sphere_links_.at(k),spheres_.col(k).head<3>().norm());
+}
+
+double SdfCollisionChecker::clearance(const Eigen::VectorXd& configuration, Eigen::VectorXd& spheres_clearance)
+{
+  state_->setJointGroupPositions(jmg_,configuration);
+  state_->updateLinkTransforms();
+
+  spheres_clearance.resize(spheres_.cols());
+  for(unsigned int k=0;k<sphere_links_.size();k++)
+  {
+    Eigen::Vector3d center = state_->getGlobalLinkTransform(sphere_links_.at(k))*Eigen::Vector3d(spheres_.col(k).head<3>());
+    spheres_clearance(k) = distance_field_->distance(center)-spheres_(3,k);
+  }
+
+  return (spheres_clearance.size()>0)? spheres_clearance.minCoeff(): distance_field_->getTruncation();
+}
+
+bool SdfCollisionChecker::checkSelfCollision(const Eigen::VectorXd& configuration)
+{
+  state_->setJointGroupPositions(jmg_,configuration);
+  state_->update();
+
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  req.group_name = group_name_;
+
+  planning_scene_->checkSelfCollision(req,res,*state_);
+
+  return not res.collision;
+}
+
+double SdfCollisionChecker::selfDistance(const Eigen::VectorXd& configuration)
+{
+  state_->setJointGroupPositions(jmg_,configuration);
+  state_->update();
+
+  collision_detection::DistanceRequest req;
+  req.group_name = group_name_;
+  req.enableGroup(planning_scene_->getRobotModel());
+  req.acm = &planning_scene_->getAllowedCollisionMatrix();
+  req.type = collision_detection::DistanceRequestType::GLOBAL;
+
+  collision_detection::DistanceResult res;
+  planning_scene_->getCollisionEnv()->distanceSelf(req,res,*state_);
+
+  return res.collision? 0.0: res.minimum_distance.distance;
+}
+
+void SdfCollisionChecker::setPlanningSceneMsg(const moveit_msgs::PlanningScene& msg)
+{
+  if(not planning_scene_->setPlanningSceneMsg(msg))
+    ROS_ERROR("unable to update planning scene");
+
+  if(not msg.is_diff || not msg.robot_state.attached_collision_objects.empty())
+  {
+    *state_ = planning_scene_->getCurrentState();
+    updateAttachedBodies();
+  }
+
+  if(distance_field_->needsUpdate(msg.world,msg.is_diff))
+  {
+    if(not owns_distance_field_)
+    {
+      distance_field_ = std::make_shared<DistanceField>(*distance_field_);
+      owns_distance_field_ = true;
+    }
+
+    distance_field_->setWorldMsg(msg.world,msg.is_diff,planning_scene_);
+  }
+}
+
+bool SdfCollisionChecker::check(const Eigen::VectorXd& configuration)
+{
+  Eigen::VectorXd spheres_clearance;
+  if(clearance(configuration,spheres_clearance)<=0.0)
+    return false;
+
+  if(check_self_collisions_ && not checkSelfCollision(configuration))
+    return false;
+
+  return true;
+}
+
+bool SdfCollisionChecker::checkPath(const Eigen::VectorXd& configuration1, const Eigen::VectorXd& configuration2)
+{
+  double length = (configuration2-configuration1).norm();
+  if(length<min_distance_)
+    return (check(configuration1) && check(configuration2));
+
+  Eigen::VectorXd direction = (configuration2-configuration1)/length;
+  Eigen::VectorXd velocity = lever_arms_*direction.cwiseAbs(); //bound of the motion of each sphere per unit of length
+
+  Eigen::VectorXd spheres_clearance;
+  double s = 0.0;
+  while(true)
+  {
+    Eigen::VectorXd conf = configuration1+s*direction;
+    if(clearance(conf,spheres_clearance)<=0.0)
+      return false;
+
+    if(s>=length)
+      break;
+
+    // No sphere can reach an obstacle before this step
+    double step = std::numeric_limits<double>::infinity();
+    for(unsigned int k=0;k<(unsigned int) spheres_clearance.size();k++)
+    {
+      if(velocity(k)>0.0)
+        step = std::min(step,spheres_clearance(k)/velocity(k));
+    }
+
+    s = std::min(s+std::max(step,min_distance_),length);
+  }
+
+  if(check_self_collisions_)
+  {
+    // Two bodies can not approach faster than twice the fastest one
+    double self_velocity = 0.0;
+    if(link_lever_arms_.rows()>0)
+      self_velocity = 2.0*(link_lever_arms_*direction.cwiseAbs()).maxCoeff();
+    if(velocity.size()>0)
+      self_velocity = std::max(self_velocity,2.0*velocity.maxCoeff());
+
+    s = 0.0;
+    while(true)
+    {
+      double self_distance = selfDistance(configuration1+s*direction);
+      if(self_distance<=0.0)
+        return false;
+
+      if(s>=length)
+        break;
+
+      double step = (self_velocity>0.0)? self_distance/self_velocity: std::numeric_limits<double>::infinity();
+      s = std::min(s+std::max(step,min_distance_),length);
+    }
+  }
+
+  return true;
+}
+
+CollisionCheckerPtr SdfCollisionChecker::clone()
+{
+  std::vector<std::string> sphere_links;
+  for(const robot_model::LinkModel* link:robot_sphere_links_)
+    sphere_links.push_back(link->getName());
+
+  // From now on the field is shared with the clone
+  owns_distance_field_ = false;
+
+  return std::make_shared<SdfCollisionChecker>(planning_scene::PlanningScene::clone(planning_scene_),group_name_,distance_field_,
+                                               sphere_links,robot_spheres_,check_self_collisions_,min_distance_);
+}
+}
@@ -0,0 +1,229 @@
+#include "replanners_lib/shared_joint_target.h"
+
+namespace pathplan
+{
+
+static const uint32_t SHARED_JOINT_TARGET_MAGIC   = 0x5447544a; //"JTGT"
+static const uint32_t SHARED_JOINT_TARGET_VERSION = 1;
+static const size_t   ALIGNMENT = 64;
+static const unsigned int MAX_READ_ATTEMPTS = 1000;
+
+static size_t align(const size_t& size)
+{
+  return ((size+ALIGNMENT-1)/ALIGNMENT)*ALIGNMENT;
+}
+
+size_t SharedJointTarget::slotSize(const unsigned int& dof)
+{
+  return align(sizeof(std::atomic<uint64_t>)+(1+4*dof)*sizeof(double));
+}
+
+size_t SharedJointTarget::memorySize(const unsigned int& dof, const unsigned int& capacity)
+{
+  return align(sizeof(Header))+(capacity+1)*slotSize(dof);
+}
+
+char* SharedJointTarget::slot(const uint64_t& idx) const
+{
+  return static_cast<char*>(memory_)+align(sizeof(Header))+idx*slot_size_;
+}
+
+SharedJointTarget::SharedJointTarget(const std::string& name, const unsigned int& dof, const unsigned int& capacity):
+  name_(name),
+  owner_(true),
+  dof_(dof),
+  capacity_(capacity)
+{
+  if(dof_ == 0 || capacity_ == 0)
+    throw std::invalid_argument("dof and capacity must be positive");
+
+  slot_size_ = slotSize(dof_);
+  size_ = memorySize(dof_,capacity_);
+
+  if(name_.empty())
+    memory_ = mmap(nullptr,size_,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+  else
+  {
+    shm_unlink(name_.c_str()); //left by a writer which did not exit cleanly
+
+    int fd = shm_open(name_.c_str(),O_CREAT|O_EXCL|O_RDWR,0660);
+    if(fd<0)
+      throw std::runtime_error("unable to create shared memory "+name_);
+
+    if(ftruncate(fd,size_)<0)
+    {
+      close(fd);
+      shm_unlink(name_.c_str());
+      throw std::runtime_error("unable to size shared memory "+name_);
+    }
+
+    memory_ = mmap(nullptr,size_,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    close(fd);
+  }
+
+  if(memory_ == MAP_FAILED)
+  {
+    if(not name_.empty())
+      shm_unlink(name_.c_str());
+    throw std::runtime_error("unable to map shared memory "+name_);
+  }
+
+  header_ = new(memory_) Header;
+  header_->version  = SHARED_JOINT_TARGET_VERSION;
+  header_->dof      = dof_;
+  header_->capacity = capacity_;
+  header_->n_written.store(0,std::memory_order_relaxed);
+
+  for(unsigned int i=0;i<=capacity_;i++)
+    new(slot(i)) std::atomic<uint64_t>(0);
+
+  // Readers check the magic number last written
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->magic = SHARED_JOINT_TARGET_MAGIC;
+}
+
+SharedJointTarget::SharedJointTarget(const std::string& name):
+  name_(name),
+  owner_(false)
+{
+  int fd = shm_open(name_.c_str(),O_RDONLY,0);
+  if(fd<0)
+    throw std::runtime_error("unable to open shared memory "+name_);
+
+  struct stat memory_stat;
+  if(fstat(fd,&memory_stat)<0 || (size_t) memory_stat.st_size<align(sizeof(Header)))
+  {
+    close(fd);
+    throw std::runtime_error("shared memory "+name_+" not initialized");
+  }
+
+  size_ = memory_stat.st_size;
+  memory_ = mmap(nullptr,size_,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);
+
+  if(memory_ == MAP_FAILED)
+    throw std::runtime_error("unable to map shared memory "+name_);
+
+  header_ = static_cast<Header*>(memory_);
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  if(header_->magic != SHARED_JOINT_TARGET_MAGIC || header_->version != SHARED_JOINT_TARGET_VERSION ||
+     size_<memorySize(header_->dof,header_->capacity))
+  {
+    munmap(memory_,size_);
+    throw std::runtime_error("shared memory "+name_+" is not a joint target");
+  }
+
+  dof_ = header_->dof;
+  capacity_ = header_->capacity;
+  slot_size_ = slotSize(dof_);
+}
+
+SharedJointTarget::~SharedJointTarget()
+{
+  munmap(memory_,size_);
+
+  if(owner_ && not name_.empty())
+    shm_unlink(name_.c_str());
+}
+
+void SharedJointTarget::writeSlot(char* slot, const uint64_t& sequence, const Target& target, const unsigned int& dof)
+{
+  std::atomic<uint64_t>* seq = reinterpret_cast<std::atomic<uint64_t>*>(slot);
+  double* data = reinterpret_cast<double*>(slot+sizeof(std::atomic<uint64_t>));
+
+  seq->store(sequence-1,std::memory_order_relaxed); //odd while writing
+  std::atomic_thread_fence(std::memory_order_release);
+
+  data[0] = target.stamp;
+  std::memcpy(data+1,      target.positions          .data(),dof*sizeof(double));
+  std::memcpy(data+1+dof,  target.velocities         .data(),dof*sizeof(double));
+  std::memcpy(data+1+2*dof,target.unscaled_positions .data(),dof*sizeof(double));
+  std::memcpy(data+1+3*dof,target.unscaled_velocities.data(),dof*sizeof(double));
+
+  seq->store(sequence,std::memory_order_release);
+}
+
+bool SharedJointTarget::readSlot(const char* slot, uint64_t& sequence, Target& target, const unsigned int& dof)
+{
+  const std::atomic<uint64_t>* seq = reinterpret_cast<const std::atomic<uint64_t>*>(slot);
+  const double* data = reinterpret_cast<const double*>(slot+sizeof(std::atomic<uint64_t>));
+
+  target.positions          .resize(dof);
+  target.velocities         .resize(dof);
+  target.unscaled_positions .resize(dof);
+  target.unscaled_velocities.resize(dof);
+
+  for(unsigned int attempt=0;attempt<MAX_READ_ATTEMPTS;attempt++)
+  {
+    uint64_t s1 = seq->load(std::memory_order_acquire);
+    if(s1 & 1) //being written
+      continue;
+
+    target.stamp = data[0];
+    std::memcpy(target.positions          .data(),data+1,      dof*sizeof(double));
+    std::memcpy(target.velocities         .data(),data+1+dof,  dof*sizeof(double));
+    std::memcpy(target.unscaled_positions .data(),data+1+2*dof,dof*sizeof(double));
+    std::memcpy(target.unscaled_velocities.data(),data+1+3*dof,dof*sizeof(double));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(seq->load(std::memory_order_relaxed) == s1)
+    {
+      sequence = s1;
+      return true;
+    }
+  }
+
+  return false; //the writer stopped in the middle of a write
+}
+
+void SharedJointTarget::write(const Target& target)
+{
+  if(not owner_)
+    throw std::runtime_error("shared memory "+name_+" opened as reader");
+
+  if(target.positions.size() != dof_ || target.velocities.size() != dof_ ||
+     target.unscaled_positions.size() != dof_ || target.unscaled_velocities.size() != dof_)
+    throw std::invalid_argument("target of wrong size");
+
+  uint64_t n = header_->n_written.load(std::memory_order_relaxed);
+  uint64_t sequence = 2*n+2;
+
+  writeSlot(slot(1+n%capacity_),sequence,target,dof_);
+  writeSlot(slot(0),sequence,target,dof_);
+
+  header_->n_written.store(n+1,std::memory_order_release);
+}
+
+bool SharedJointTarget::readLatest(Target& target) const
+{
+  uint64_t sequence;
+  return readSlot(slot(0),sequence,target,dof_) && sequence>0;
+}
+
+bool SharedJointTarget::read(uint64_t& idx, Target& target) const
+{
+  uint64_t n_written = getWrittenNumber();
+  if(idx>=n_written)
+    return false;
+
+  if(idx+capacity_<n_written)
+  {
+    idx = n_written-capacity_;
+    return false;
+  }
+
+  uint64_t sequence;
+  if(not readSlot(slot(1+idx%capacity_),sequence,target,dof_))
+    return false;
+
+  if(sequence != 2*idx+2) //overwritten while reading
+  {
+    n_written = getWrittenNumber();
+    idx = (n_written>capacity_)? n_written-capacity_: 0;
+    return false;
+  }
+
+  return true;
+}
+}
@@ -0,0 +1,285 @@
+#include "replanners_lib/swept_volume_grid.h"
+
+namespace pathplan
+{
+
+static Eigen::Isometry3d fromPoseMsg(const geometry_msgs::Pose& pose)
+{
+  Eigen::Quaterniond q(pose.orientation.w,pose.orientation.x,pose.orientation.y,pose.orientation.z);
+  if(q.norm()<1e-6)
+    q = Eigen::Quaterniond::Identity();
+
+  Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+  T.linear() = q.normalized().toRotationMatrix();
+  T.translation()<<pose.position.x,pose.position.y,pose.position.z;
+
+  return T;
+}
+
+static void extend(Eigen::AlignedBox3d& box, const Eigen::Isometry3d& T, const Eigen::Vector3d& center, const Eigen::Vector3d& half_extents)
+{
+  Eigen::Vector3d c = T*center;
+  Eigen::Vector3d h = T.linear().cwiseAbs()*half_extents;
+
+  box.extend(c-h);
+  box.extend(c+h);
+}
+
+SweptVolumeGrid::SweptVolumeGrid(const robot_model::RobotModelConstPtr& robot_model,
+                                 const std::string& group_name,
+                                 const double& cell_size,
+                                 const double& resolution,
+                                 const double& margin):
+  cell_size_(cell_size),
+  resolution_(resolution),
+  margin_(margin)
+{
+  if(cell_size_<=0.0 || resolution_<=0.0)
+    throw std::invalid_argument("cell size and resolution must be positive");
+
+  state_ = std::make_shared<robot_state::RobotState>(robot_model);
+  state_->setToDefaultValues();
+
+  jmg_ = state_->getJointModelGroup(group_name);
+  if(not jmg_)
+    throw std::invalid_argument("group "+group_name+" does not exist");
+
+  for(const robot_model::LinkModel* link:jmg_->getUpdatedLinkModelsWithGeometry())
+    links_.push_back(link);
+}
+
+int64_t SweptVolumeGrid::key(const Eigen::Vector3i& cell) const
+{
+  // 21 bits for each coordinate, enough for +-100 km with 0.1 m cells
+  return ((int64_t) (cell(0) & 0x1FFFFF)<<42) | ((int64_t) (cell(1) & 0x1FFFFF)<<21) | (int64_t) (cell(2) & 0x1FFFFF);
+}
+
+Eigen::Vector3i SweptVolumeGrid::cell(const Eigen::Vector3d& point) const
+{
+  return (point/cell_size_).array().floor().cast<int>();
+}
+
+void SweptVolumeGrid::addBox(const Eigen::AlignedBox3d& box, const unsigned int& conn_idx)
+{
+  Eigen::Vector3i first = cell(box.min());
+  Eigen::Vector3i last  = cell(box.max());
+
+  for(int ix=first(0);ix<=last(0);ix++)
+  {
+    for(int iy=first(1);iy<=last(1);iy++)
+    {
+      for(int iz=first(2);iz<=last(2);iz++)
+      {
+        // Connections are added in order, so a duplicate can only be the last element
+        std::vector<unsigned int>& conns = cells_[key(Eigen::Vector3i(ix,iy,iz))];
+        if(conns.empty() || conns.back() != conn_idx)
+          conns.push_back(conn_idx);
+      }
+    }
+  }
+}
+
+void SweptVolumeGrid::setPath(const PathPtr& path)
+{
+  cells_.clear();
+  conn_boxes_.clear();
+
+  std::vector<ConnectionPtr> conns = path->getConnections();
+  conn_boxes_.resize(conns.size());
+  for(unsigned int i=0;i<conns.size();i++)
+  {
+    Eigen::VectorXd parent = conns.at(i)->getParent()->getConfiguration();
+    Eigen::VectorXd child  = conns.at(i)->getChild ()->getConfiguration();
+
+    unsigned int n_samples = std::ceil((child-parent).norm()/resolution_);
+    for(unsigned int j=0;j<=n_samples;j++)
+    {
+      state_->setJointGroupPositions(jmg_,(n_samples>0)? Eigen::VectorXd(parent+(child-parent)*j/n_samples): parent);
+      state_->updateLinkTransforms();
+
+      for(const robot_model::LinkModel* link:links_)
+      {
+        Eigen::AlignedBox3d box;
+        box.setEmpty();
+        extend(box,state_->getGlobalLinkTransform(link),link->getCenteredBoundingBoxOffset(),0.5*link->getShapeExtentsAtOrigin());
+
+        box.min().array() -= margin_;
+        box.max().array() += margin_;
+        addBox(box,i);
+        conn_boxes_.at(i).push_back(box);
+      }
+    }
+  }
+}
+
+std::vector<unsigned int> SweptVolumeGrid::connectionsInRegions(const std::vector<Eigen::AlignedBox3d>& regions) const
+{
+  std::vector<unsigned int> conns;
+  for(const Eigen::AlignedBox3d& region:regions)
+  {
+    if(region.isEmpty())
+      continue;
+
+    // Regions larger than the swept volume (e.g. planes) are not scanned cell by cell: every connection is affected
+    double n_cells = ((region.max()-region.min())/cell_size_+Eigen::Vector3d::Ones()).prod();
+    if(n_cells>(double) cells_.size())
+    {
+      for(const std::pair<const int64_t,std::vector<unsigned int>>& c:cells_)
+        conns.insert(conns.end(),c.second.begin(),c.second.end());
+      continue;
+    }
+
+    Eigen::Vector3i first = cell(region.min());
+    Eigen::Vector3i last  = cell(region.max());
+
+    for(int ix=first(0);ix<=last(0);ix++)
+    {
+      for(int iy=first(1);iy<=last(1);iy++)
+      {
+        for(int iz=first(2);iz<=last(2);iz++)
+        {
+          std::unordered_map<int64_t,std::vector<unsigned int>>::const_iterator it = cells_.find(key(Eigen::Vector3i(ix,iy,iz)));
+          if(it != cells_.end())
+            conns.insert(conns.end(),it->second.begin(),it->second.end());
+        }
+      }
+    }
+  }
+
+  std::sort(conns.begin(),conns.end());
+  conns.erase(std::unique(conns.begin(),conns.end()),conns.end());
+
+  return conns;
+}
+
+double SweptVolumeGrid::distance(const unsigned int& conn_idx, const std::vector<Eigen::AlignedBox3d>& boxes) const
+{
+  double min_squared_distance = std::numeric_limits<double>::infinity();
+  if(conn_idx>=conn_boxes_.size())
+    return 0.0;
+
+  for(const Eigen::AlignedBox3d& conn_box:conn_boxes_.at(conn_idx))
+  {
+    for(const Eigen::AlignedBox3d& box:boxes)
+    {
+      if(not box.isEmpty())
+        min_squared_distance = std::min(min_squared_distance,conn_box.squaredExteriorDistance(box));
+    }
+  }
+
+  return std::sqrt(min_squared_distance);
+}
+
+Eigen::AlignedBox3d SweptVolumeGrid::objectBox(const moveit_msgs::CollisionObject& object, const planning_scene::PlanningSceneConstPtr& scene)
+{
+  Eigen::AlignedBox3d box;
+  box.setEmpty();
+
+  Eigen::Isometry3d object_pose = fromPoseMsg(object.pose);
+  if(scene && not object.header.frame_id.empty())
+    object_pose = scene->getFrameTransform(object.header.frame_id)*object_pose;
+
+  Eigen::Vector3d half_extents;
+  for(unsigned int i=0;i<object.primitives.size() && i<object.primitive_poses.size();i++)
+  {
+    const shape_msgs::SolidPrimitive& primitive = object.primitives.at(i);
+    switch(primitive.type)
+    {
+    case shape_msgs::SolidPrimitive::SPHERE:
+      half_extents.setConstant(primitive.dimensions.at(shape_msgs::SolidPrimitive::SPHERE_RADIUS));
+      break;
+    case shape_msgs::SolidPrimitive::BOX:
+      half_extents<<primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_X),
+          primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_Y),
+          primitive.dimensions.at(shape_msgs::SolidPrimitive::BOX_Z);
+      half_extents = 0.5*half_extents;
+      break;
+    case shape_msgs::SolidPrimitive::CYLINDER:
+    case shape_msgs::SolidPrimitive::CONE:
+    {
+      // CYLINDER_HEIGHT == CONE_HEIGHT and CYLINDER_RADIUS == CONE_RADIUS
+      double r = primitive.dimensions.at(shape_msgs::SolidPrimitive::CYLINDER_RADIUS);
+      half_extents<<r,r,0.5*primitive.dimensions.at(shape_msgs::SolidPrimitive::CYLINDER_HEIGHT);
+      break;
+    }
+    default: //unknown shape, the whole world may be affected
+      half_extents.setConstant(1.0e6);
+    }
+
+    extend(box,object_pose*fromPoseMsg(object.primitive_poses.at(i)),Eigen::Vector3d::Zero(),half_extents);
+  }
+
+  for(unsigned int i=0;i<object.meshes.size() && i<object.mesh_poses.size();i++)
+  {
+    Eigen::AlignedBox3d bounds;
+    for(const geometry_msgs::Point& v:object.meshes.at(i).vertices)
+      bounds.extend(Eigen::Vector3d(v.x,v.y,v.z));
+
+    if(not bounds.isEmpty())
+      extend(box,object_pose*fromPoseMsg(object.mesh_poses.at(i)),bounds.center(),0.5*bounds.sizes());
+  }
+
+  if(not object.planes.empty()) //infinite planes cross the whole world
+  {
+    box.extend(Eigen::Vector3d::Constant(-1.0e6));
+    box.extend(Eigen::Vector3d::Constant( 1.0e6));
+  }
+
+  return box;
+}
+
+Eigen::AlignedBox3d SweptVolumeGrid::octreeBox(const octomap::OcTree& octree, const Eigen::Isometry3d& pose)
+{
+  Eigen::AlignedBox3d box;
+  box.setEmpty();
+
+  if(octree.size() == 0)
+    return box;
+
+  Eigen::Vector3d min, max;
+  octree.getMetricMin(min(0),min(1),min(2));
+  octree.getMetricMax(max(0),max(1),max(2));
+
+  extend(box,pose,0.5*(min+max),0.5*(max-min));
+
+  return box;
+}
+
+std::vector<Eigen::AlignedBox3d> SweptVolumeGrid::changedRegions(const moveit_msgs::PlanningSceneWorld& world,
+                                                                 std::map<std::string,moveit_msgs::CollisionObject>& objects,
+                                                                 const planning_scene::PlanningSceneConstPtr& scene)
+{
+  std::vector<Eigen::AlignedBox3d> regions;
+  std::map<std::string,moveit_msgs::CollisionObject> new_objects;
+
+  for(const moveit_msgs::CollisionObject& obj:world.collision_objects)
+  {
+    new_objects[obj.id] = obj;
+
+    std::map<std::string,moveit_msgs::CollisionObject>::iterator it = objects.find(obj.id);
+    if(it != objects.end())
+    {
+      if(obj.header.frame_id == it->second.header.frame_id && obj.pose == it->second.pose &&
+         obj.primitives == it->second.primitives && obj.primitive_poses == it->second.primitive_poses &&
+         obj.meshes     == it->second.meshes     && obj.mesh_poses      == it->second.mesh_poses     &&
+         obj.planes     == it->second.planes     && obj.plane_poses     == it->second.plane_poses)
+      {
+        objects.erase(it);
+        continue;
+      }
+
+      regions.push_back(objectBox(it->second,scene)); //old pose
+      objects.erase(it);
+    }
+
+    regions.push_back(objectBox(obj,scene));
+  }
+
+  for(const std::pair<const std::string,moveit_msgs::CollisionObject>& obj:objects) //removed objects
+    regions.push_back(objectBox(obj.second,scene));
+
+  objects = new_objects;
+
+  return regions;
+}
+}
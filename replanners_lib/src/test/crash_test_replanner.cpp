@@ -8,6 +8,8 @@
 #include <replanners_lib/replanners/DRRT.h>
 #include <replanners_lib/replanners/anytimeDRRT.h>
 #include <replanners_lib/replanners/MARS.h>
+#include <replanners_lib/analytic_collision_checker.h>
+#include <replanners_lib/continuous_collision_checker.h>
 #include <graph_core/parallel_moveit_collision_checker.h>
 #include <graph_core/solvers/birrt.h>
 
@@ -27,8 +29,9 @@ int main(int argc, char **argv)
   int n_iter, n_other_paths;
   std::vector<double> start_configuration, stop_configuration;
   std::string group_name, replanner_type;
-  bool full_search, reverse, opt, display, verbosity;
-  double max_time, max_distance;
+  bool full_search, reverse, opt, display, verbosity, analytic_checker, continuous_checker;
+  double max_time, max_distance, checker_resolution;
+  std::vector<double> robot_spheres;
 
   nh.getParam("n_iter",n_iter);
   nh.getParam("replanner_type",replanner_type);
@@ -40,6 +43,30 @@ int main(int argc, char **argv)
   nh.getParam("display",display);
   nh.getParam("verbosity",verbosity);
 
+  if(!nh.getParam("analytic_checker",analytic_checker))
+    analytic_checker = false;
+
+  if(!nh.getParam("continuous_checker",continuous_checker))
+    continuous_checker = false;
+
+  if(analytic_checker || continuous_checker)
+  {
+    if(!nh.getParam("checker_resolution",checker_resolution))
+    {
+      ROS_ERROR("checker_resolution not set, set 0.01");
+      checker_resolution = 0.01;
+    }
+  }
+
+  if(analytic_checker)
+  {
+    if(!nh.getParam("robot_spheres",robot_spheres) || robot_spheres.size()%4 != 0)
+    {
+      ROS_ERROR("robot_spheres not set or not a list of [x,y,z,radius], the robot is a point");
+      robot_spheres = {0.0,0.0,0.0,0.0};
+    }
+  }
+
   if(replanner_type == "MARS")
   {
     nh.getParam("/MARS/n_other_paths",n_other_paths);
@@ -130,7 +157,16 @@ int main(int argc, char **argv)
 
     pathplan::MetricsPtr metrics = std::make_shared<pathplan::Metrics>();
 
-    pathplan::CollisionCheckerPtr checker = std::make_shared<pathplan::ParallelMoveitCollisionChecker>(planning_scene, group_name);
+    pathplan::CollisionCheckerPtr checker;
+    if(analytic_checker)
+    {
+      checker = std::make_shared<pathplan::AnalyticCollisionChecker>(Eigen::Map<Eigen::Matrix4Xd>(robot_spheres.data(),4,robot_spheres.size()/4),checker_resolution);
+      checker->setPlanningSceneMsg(ps_srv.response.scene);
+    }
+    else if(continuous_checker)
+      checker = std::make_shared<pathplan::ContinuousCollisionChecker>(planning_scene,group_name,true,checker_resolution);
+    else
+      checker = std::make_shared<pathplan::ParallelMoveitCollisionChecker>(planning_scene, group_name);
     pathplan::SamplerPtr sampler = std::make_shared<pathplan::InformedSampler>(start_conf,goal_conf,lb,ub);
     pathplan::RRTPtr solver = std::make_shared<pathplan::RRT>(metrics,checker,sampler);
     solver->setMaxDistance(max_distance);
@@ -0,0 +1,59 @@
+#include "replanners_lib/time_parameterization.h"
+
+namespace pathplan
+{
+
+TimeParameterizerPtr TimeParameterizer::fromName(const std::string& name, const double& path_tolerance, const double& resample_dt)
+{
+  if(name == "iterative_parabolic")
+    return std::make_shared<IterativeParabolicParameterizer>();
+  else if(name == "iterative_spline")
+    return std::make_shared<IterativeSplineParameterizer>();
+  else if(name == "time_optimal")
+    return std::make_shared<TimeOptimalParameterizer>(path_tolerance,resample_dt);
+  else if(name == "trapezoidal")
+    return std::make_shared<TrapezoidalParameterizer>();
+  else
+    return nullptr;
+}
+
+bool TrapezoidalParameterizer::computeTimeStamps(robot_trajectory::RobotTrajectory& trj, const Eigen::VectorXd& max_velocity, const Eigen::VectorXd& max_acceleration)
+{
+  if(trj.empty())
+    return false;
+
+  const robot_model::JointModelGroup* jmg = trj.getGroup();
+  if(not jmg)
+    return false;
+
+  std::vector<Eigen::VectorXd> waypoints;
+  Eigen::VectorXd q;
+  for(unsigned int i=0;i<trj.getWayPointCount();i++)
+  {
+    trj.getWayPoint(i).copyJointGroupPositions(jmg,q);
+    waypoints.push_back(q);
+  }
+
+  // The jerk is not limited by the path timing
+  Eigen::VectorXd max_jerk = Eigen::VectorXd::Constant(max_velocity.size(),std::numeric_limits<double>::infinity());
+  OnlineTrajectoryGenerator otg(max_velocity,max_acceleration,max_jerk);
+
+  std::vector<OnlineTrajectoryGenerator::Setpoint> setpoints = otg.timePath(waypoints,Eigen::VectorXd::Zero(max_velocity.size()));
+
+  moveit::core::RobotState state = trj.getWayPoint(0);
+  trj.clear();
+
+  double previous_time = 0.0;
+  for(const OnlineTrajectoryGenerator::Setpoint& setpoint:setpoints)
+  {
+    state.setJointGroupPositions    (jmg,setpoint.position    );
+    state.setJointGroupVelocities   (jmg,setpoint.velocity    );
+    state.setJointGroupAccelerations(jmg,setpoint.acceleration);
+
+    trj.addSuffixWayPoint(state,setpoint.time-previous_time);
+    previous_time = setpoint.time;
+  }
+
+  return true;
+}
+}
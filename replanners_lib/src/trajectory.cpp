@@ -14,6 +14,9 @@ Trajectory::Trajectory(const PathPtr path,
   planning_scene_ = planning_scene;
   group_name_ = group_name;
   moveit_utils_ = std::make_shared<MoveitUtils>(planning_scene,group_name);
+  time_parameterizer_ = std::make_shared<IterativeParabolicParameterizer>();
+  parameterization_time_ = 0.0;
+  loadJointLimits();
 }
 
 Trajectory::Trajectory(const ros::NodeHandle &nh,
@@ -27,17 +30,22 @@ Trajectory::Trajectory(const ros::NodeHandle &nh,
   planning_scene_ = planning_scene;
   group_name_ = group_name;
   moveit_utils_ = std::make_shared<MoveitUtils>(planning_scene,group_name);
+  time_parameterizer_ = std::make_shared<IterativeParabolicParameterizer>();
+  parameterization_time_ = 0.0;
+  loadJointLimits();
 }
 
-PathPtr Trajectory::computePath(const Eigen::VectorXd& start_conf, const Eigen::VectorXd& goal_conf, const TreeSolverPtr& solver, const bool& optimizePath, const double &max_time)
+PathPtr Trajectory::computePath(const Eigen::VectorXd& start_conf, const Eigen::VectorXd& goal_conf, const TreeSolverPtr& solver, const bool& optimizePath, const double &max_time,
+                                const unsigned int& seed)
 {
   NodePtr start_node = std::make_shared<Node>(start_conf);
   NodePtr goal_node = std::make_shared<Node>(goal_conf);
 
-  return computePath(start_node,goal_node,solver,optimizePath,max_time);
+  return computePath(start_node,goal_node,solver,optimizePath,max_time,seed);
 }
 
-PathPtr Trajectory::computePath(const NodePtr& start_node, const NodePtr& goal_node, const TreeSolverPtr& solver, const bool& optimize, const double &max_time)
+PathPtr Trajectory::computePath(const NodePtr& start_node, const NodePtr& goal_node, const TreeSolverPtr& solver, const bool& optimize, const double &max_time,
+                                const unsigned int& seed)
 {
   ros::WallTime tic = ros::WallTime::now();
 
@@ -88,7 +96,7 @@ PathPtr Trajectory::computePath(const NodePtr& start_node, const NodePtr& goal_n
     int stall_gen = 0;
     int max_stall_gen = 200;
 
-    std::mt19937 gen;
+    std::mt19937 gen(seed);
     std::uniform_int_distribution<> id = std::uniform_int_distribution<>(0, max_stall_gen);
 
     for (unsigned int idx = 0; idx < 10000; idx++)
@@ -143,6 +151,150 @@ PathPtr Trajectory::computePath(const NodePtr& start_node, const NodePtr& goal_n
   return solution;
 }
 
+PathPtr Trajectory::computePath(const Eigen::VectorXd& start_conf, const Eigen::VectorXd& goal_conf, const TreeSolverPtr& solver, const unsigned int& n_seeds, std::vector<PathPtr>& solutions,
+                                const bool& optimizePath, const double& max_time)
+{
+  solutions.clear();
+
+  CollisionCheckerPtr checker = solver->getChecker();
+  Eigen::VectorXd lb = solver->getSampler()->getLB();
+  Eigen::VectorXd ub = solver->getSampler()->getUB();
+
+  // Each pipeline has its own seed, otherwise the optimizations would repeat the same choices
+  std::random_device rseed;
+  unsigned int seed = rseed();
+
+  std::vector<std::shared_future<PathPtr>> tasks;
+  for(unsigned int i=0;i<std::max(n_seeds,(unsigned int) 1);i++)
+  {
+    SamplerPtr sampler = std::make_shared<InformedSampler>(start_conf,goal_conf,lb,ub);
+    TreeSolverPtr seed_solver = solver->clone(solver->getMetrics()->clone(),checker->clone(),sampler);
+    seed_solver->importFromSolver(solver);
+
+    tasks.push_back(std::async(std::launch::async,[=]() ->PathPtr{
+                                 return computePath(start_conf,goal_conf,seed_solver,optimizePath,max_time,seed+i);
+                               }));
+  }
+
+  std::multimap<double,PathPtr> sorted_solutions;
+  for(unsigned int i=0;i<tasks.size();i++)
+  {
+    PathPtr solution = tasks.at(i).get();
+    if(solution)
+    {
+      solution->setChecker(checker);
+      sorted_solutions.insert(std::pair<double,PathPtr>(solution->cost(),solution));
+    }
+  }
+
+  for(const std::pair<double,PathPtr>& pair:sorted_solutions)
+    solutions.push_back(pair.second);
+
+  if(solutions.empty())
+    return nullptr;
+
+  return solutions.front();
+}
+
+std::vector<PathPtr> Trajectory::computeDiversePaths(const Eigen::VectorXd& start_conf, const Eigen::VectorXd& goal_conf, const TreeSolverPtr& solver, const unsigned int& n_paths,
+                                                     const std::vector<PathPtr>& reference_paths, const double& min_distance, const unsigned int& n_candidates,
+                                                     const bool& optimizePath, const double& max_time)
+{
+  std::vector<PathPtr> paths;
+  std::vector<PathPtr> paths2avoid = reference_paths;
+
+  for(unsigned int i=0;i<n_paths;i++)
+  {
+    PathPtr best_candidate = nullptr;
+    double best_score = -std::numeric_limits<double>::infinity();
+
+    // Candidates are computed concurrently with fresh samplers and solvers, so that previous solutions do not bias the sampling
+    std::vector<PathPtr> candidates;
+    computePath(start_conf,goal_conf,solver,n_candidates,candidates,optimizePath,max_time);
+
+    for(const PathPtr& candidate:candidates)
+    {
+      double distance = std::numeric_limits<double>::infinity();
+      for(const PathPtr& p:paths2avoid)
+        distance = std::min(distance,frechetDistance(candidate,p));
+
+      if(distance<min_distance)
+      {
+        ROS_INFO_STREAM("candidate path rejected, Frechet distance from the other paths "<<distance<<" < "<<min_distance);
+        continue;
+      }
+
+      double score = (distance<std::numeric_limits<double>::infinity())? (distance/candidate->getWaypoints().size()):
+                                                                           (-candidate->cost()); //no path to compare with, the cheapest one wins
+      if(score>best_score)
+      {
+        best_score = score;
+        best_candidate = candidate;
+      }
+    }
+
+    if(best_candidate)
+    {
+      paths.push_back(best_candidate);
+      paths2avoid.push_back(best_candidate);
+    }
+    else
+      ROS_INFO("no diverse path found");
+  }
+
+  return paths;
+}
+
+std::vector<Eigen::VectorXd> Trajectory::resampleWaypoints(const PathPtr& path, const double& resolution)
+{
+  std::vector<Eigen::VectorXd> waypoints = path->getWaypoints();
+  std::vector<Eigen::VectorXd> resampled_waypoints;
+
+  resampled_waypoints.push_back(waypoints.front());
+  for(unsigned int i=1;i<waypoints.size();i++)
+  {
+    Eigen::VectorXd segment = waypoints.at(i)-waypoints.at(i-1);
+    unsigned int n_steps = std::max(std::ceil(segment.norm()/resolution),1.0);
+
+    for(unsigned int j=1;j<=n_steps;j++)
+      resampled_waypoints.push_back(waypoints.at(i-1)+segment*((double) j/n_steps));
+  }
+
+  return resampled_waypoints;
+}
+
+double Trajectory::frechetDistance(const PathPtr& path1, const PathPtr& path2, const double& resolution)
+{
+  /* Discrete Frechet distance between the configuration-space polylines of the two paths.
+   * Paths in different homotopy classes are separated by obstacles, so they have a large distance */
+  std::vector<Eigen::VectorXd> wp1 = resampleWaypoints(path1,resolution);
+  std::vector<Eigen::VectorXd> wp2 = resampleWaypoints(path2,resolution);
+
+  unsigned int n = wp1.size();
+  unsigned int m = wp2.size();
+
+  std::vector<double> prev_row(m), row(m);
+  for(unsigned int i=0;i<n;i++)
+  {
+    for(unsigned int j=0;j<m;j++)
+    {
+      double d = (wp1.at(i)-wp2.at(j)).norm();
+
+      if(i == 0 && j == 0)
+        row.at(j) = d;
+      else if(i == 0)
+        row.at(j) = std::max(row.at(j-1),d);
+      else if(j == 0)
+        row.at(j) = std::max(prev_row.at(j),d);
+      else
+        row.at(j) = std::max(std::min({prev_row.at(j),prev_row.at(j-1),row.at(j-1)}),d);
+    }
+    prev_row.swap(row);
+  }
+
+  return prev_row.back();
+}
+
 robot_trajectory::RobotTrajectoryPtr Trajectory::fromPath2Trj(const trajectory_msgs::JointTrajectoryPoint &pnt)
 {
   trajectory_msgs::JointTrajectoryPoint::Ptr pnt_ptr(new trajectory_msgs::JointTrajectoryPoint());
@@ -157,11 +309,86 @@ robot_trajectory::RobotTrajectoryPtr Trajectory::fromPath2Trj(const trajectory_m
 }
 
 
+void Trajectory::loadJointLimits()
+{
+  const robot_model::JointModelGroup* jmg = kinematic_model_->getJointModelGroup(group_name_);
+  const std::vector<std::string>& names = jmg->getActiveJointModelNames();
+
+  max_velocity_    .setOnes(names.size());
+  max_acceleration_.setOnes(names.size());
+  for(unsigned int i=0;i<names.size();i++)
+  {
+    const robot_model::VariableBounds& bounds = kinematic_model_->getVariableBounds(names.at(i));
+    if(bounds.velocity_bounded_)
+      max_velocity_(i) = std::min(std::abs(bounds.min_velocity_),std::abs(bounds.max_velocity_));
+    if(bounds.acceleration_bounded_)
+      max_acceleration_(i) = std::min(std::abs(bounds.min_acceleration_),std::abs(bounds.max_acceleration_));
+  }
+}
+
+robot_trajectory::RobotTrajectoryPtr Trajectory::fromPath2TrjOnline(const trajectory_msgs::JointTrajectoryPointPtr &pnt)
+{
+  std::vector<Eigen::VectorXd> waypoints=path_->getWaypoints();
+
+  std::vector<OnlineTrajectoryGenerator::Setpoint> setpoints;
+  if(pnt != nullptr)
+  {
+    unsigned int dof = waypoints.front().size();
+    if(pnt->positions.size() != dof)
+      throw std::invalid_argument("wrong size of the starting point");
+
+    Eigen::VectorXd position     = Eigen::Map<const Eigen::VectorXd>(pnt->positions.data(),dof);
+    Eigen::VectorXd velocity     = Eigen::VectorXd::Zero(dof);
+    Eigen::VectorXd acceleration = Eigen::VectorXd::Zero(dof);
+    if(pnt->velocities.size() == dof)
+      velocity = Eigen::Map<const Eigen::VectorXd>(pnt->velocities.data(),dof);
+    if(pnt->accelerations.size() == dof)
+      acceleration = Eigen::Map<const Eigen::VectorXd>(pnt->accelerations.data(),dof);
+
+    if(not otg_->generate(waypoints,position,velocity,acceleration,setpoints))
+      return nullptr;
+  }
+  else
+    setpoints = otg_->generate(waypoints);
+
+  const robot_model::JointModelGroup* jmg = kinematic_model_->getJointModelGroup(group_name_);
+  moveit::core::RobotState state = moveit_utils_->fromWaypoints2State(waypoints.front());
+
+  trj_ = std::make_shared<robot_trajectory::RobotTrajectory>(kinematic_model_,group_name_);
+  double previous_time = 0.0;
+  for(const OnlineTrajectoryGenerator::Setpoint& setpoint:setpoints)
+  {
+    state.setJointGroupPositions    (jmg,setpoint.position    );
+    state.setJointGroupVelocities   (jmg,setpoint.velocity    );
+    state.setJointGroupAccelerations(jmg,setpoint.acceleration);
+
+    trj_->addSuffixWayPoint(state,setpoint.time-previous_time);
+    previous_time = setpoint.time;
+  }
+
+  return trj_;
+}
+
 robot_trajectory::RobotTrajectoryPtr Trajectory::fromPath2Trj(const trajectory_msgs::JointTrajectoryPointPtr &pnt)
 {  
   if(not path_)
     throw std::invalid_argument("Path not assigned");
 
+  ros::WallTime tic = ros::WallTime::now();
+
+  if(otg_)
+  {
+    robot_trajectory::RobotTrajectoryPtr trj = fromPath2TrjOnline(pnt);
+    if(trj)
+    {
+      parameterization_time_ = (ros::WallTime::now()-tic).toSec();
+      return trj;
+    }
+
+    // A trajectory must exist for the path the robot is given: it is timed from pnt as without the online generator
+    ROS_WARN_STREAM("the current state cannot be spliced onto the path, time parameterization "<<time_parameterizer_->getName()<<" used");
+  }
+
   std::vector<Eigen::VectorXd> waypoints=path_->getWaypoints();
   std::vector<moveit::core::RobotState> wp_state_vector = moveit_utils_->fromWaypoints2State(waypoints);
 
@@ -178,11 +405,8 @@ robot_trajectory::RobotTrajectoryPtr Trajectory::fromPath2Trj(const trajectory_m
   }
 
   //Time parametrization
-  //trajectory_processing::IterativeSplineParameterization iptp;
-  //  trajectory_processing::TimeOptimalTrajectoryGeneration iptp;
-  trajectory_processing::IterativeParabolicTimeParameterization iptp;
-
-  iptp.computeTimeStamps(*trj_);
+  if(not time_parameterizer_->computeTimeStamps(*trj_,max_velocity_,max_acceleration_))
+    ROS_ERROR_STREAM("time parameterization "<<time_parameterizer_->getName()<<" failed");
 
   if(pnt != nullptr)
   {
@@ -215,6 +439,8 @@ robot_trajectory::RobotTrajectoryPtr Trajectory::fromPath2Trj(const trajectory_m
     trj_ = trj;
   }
 
+  parameterization_time_ = (ros::WallTime::now()-tic).toSec();
+
   return trj_;
 }
 